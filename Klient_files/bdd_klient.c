@@ -1,5 +1,6 @@
 #include "bdd_klient.h"
 #include <errno.h>
+#include <poll.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include "../Shared/comm_utils.h"
@@ -7,7 +8,25 @@
 void bdd_klient_init(bdd_klient *this) {
     this->instructions = NULL;
     this->server_socket_ = 0;
+    this->simplify_merges_ = true;
+    this->merge_mode_ = MODULE_MERGE_CUBES;
+    this->receiving_ = false;
+    this->receiver_started_ = false;
+    this->peer_socket_ = -1;
+    this->peers_ = NULL;
+    this->peer_count_ = 0;
+    this->pending_peer_modules_ = 0;
+    this->peer_receiver_started_ = false;
+    this->compress_transfers_ = false;
+    this->compressed_receivers_ = NULL;
+    this->transfer_raw_bytes_ = 0;
+    this->transfer_sent_bytes_ = 0;
+    pthread_mutex_init(&this->modules_mutex_, NULL);
+    pthread_cond_init(&this->module_received_, NULL);
     array_list_init(&this->modules_, sizeof(module*));
+    hash_map_init(&this->module_index_);
+    this->merge_threads_ = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    this->merge_executor_started_ = false;
 }
 
 void bdd_klient_destroy(bdd_klient *this) {
@@ -16,24 +35,85 @@ void bdd_klient_destroy(bdd_klient *this) {
     }
     bdd_klient_clear_klient(this);
     array_list_destroy(&this->modules_);
+    hash_map_destroy(&this->module_index_);
+    pthread_cond_destroy(&this->module_received_);
+    pthread_mutex_destroy(&this->modules_mutex_);
+}
+
+static void bdd_klient_close_peers(bdd_klient *this) {
+    if (this->peer_receiver_started_) {
+        pthread_join(this->peer_receiver_, NULL);
+        this->peer_receiver_started_ = false;
+    }
+    if (this->peer_socket_ >= 0) {
+        close(this->peer_socket_);
+        this->peer_socket_ = -1;
+    }
+    free(this->peers_);
+    this->peers_ = NULL;
+    this->peer_count_ = 0;
 }
 
 void bdd_klient_clear_klient(bdd_klient *this) {
+    bdd_klient_wait_for_modules(this);
+    bdd_klient_close_peers(this);
     free(this->instructions);
     this->instructions = NULL;
+    free(this->compressed_receivers_);
+    this->compressed_receivers_ = NULL;
+    this->transfer_raw_bytes_ = 0;
+    this->transfer_sent_bytes_ = 0;
+    if (this->merge_executor_started_) {
+        merge_executor_destroy(&this->merge_executor_);
+        this->merge_executor_started_ = false;
+    }
     array_list_process_all(&this->modules_, module_destroy_array_list);
     array_list_clear(&this->modules_);
+    hash_map_clear(&this->module_index_);
+}
+
+static _Bool bdd_klient_send_message_to(int socket, bdd_message *message) {
+    return send_all(socket, &message->serialized_buffer_size_, sizeof(message->serialized_buffer_size_)) > 0 &&
+           send_all(socket, message->serialized_buffer_, message->serialized_buffer_size_) > 0;
+}
+
+static _Bool bdd_klient_receive_message_from(int socket, bdd_message *message) {
+    if (recv_all(socket, &message->serialized_buffer_size_, sizeof(message->serialized_buffer_size_)) <= 0) {
+        return false;
+    }
+    bdd_message_allocate_buffer(message, message->serialized_buffer_size_);
+    return recv_all(socket, message->serialized_buffer_, message->serialized_buffer_size_) > 0;
+}
+
+/**
+ * @brief Waits until the receiver of a module sent on a peer connection confirms it.
+ * @return true if the receiver sent BDD_KLIENT_PEER_ACK, false if the connection ended without it.
+ */
+static _Bool bdd_klient_receive_peer_ack(int socket) {
+    char ack = 0;
+    return recv_all(socket, &ack, sizeof(ack)) > 0 && ack == BDD_KLIENT_PEER_ACK;
+}
+
+/**
+ * @brief Compresses a serialized module for its receiver if both agreed to it, and counts its size.
+ */
+static void bdd_klient_compress_module(bdd_klient *this, bdd_message *message, int receiver_id) {
+    size_t raw_size = message->serialized_buffer_size_;
+    int index = receiver_id < 0 ? 0 : receiver_id + 1;
+    if (this->compress_transfers_ && this->compressed_receivers_ &&
+        index < (int)strlen(this->compressed_receivers_) && this->compressed_receivers_[index] == '1') {
+        bdd_message_compress(message);
+    }
+    this->transfer_raw_bytes_ += raw_size;
+    this->transfer_sent_bytes_ += message->serialized_buffer_size_;
 }
 
 void bdd_klient_send_message(bdd_klient *this, bdd_message *message) {
-    send_all(this->server_socket_, &message->serialized_buffer_size_, sizeof(message->serialized_buffer_size_));
-    send_all(this->server_socket_, message->serialized_buffer_, message->serialized_buffer_size_);
+    bdd_klient_send_message_to(this->server_socket_, message);
 }
 
 void bdd_klient_receive_message(bdd_klient *this, bdd_message *message) {
-    recv_all(this->server_socket_, &message->serialized_buffer_size_, sizeof(message->serialized_buffer_size_));
-    bdd_message_allocate_buffer(message, message->serialized_buffer_size_);
-    recv_all(this->server_socket_, message->serialized_buffer_, message->serialized_buffer_size_);
+    bdd_klient_receive_message_from(this->server_socket_, message);
 }
 
 _Bool bdd_klient_connect(bdd_klient *this, char *server_ip, int server_port) {
@@ -59,6 +139,10 @@ _Bool bdd_klient_connect(bdd_klient *this, char *server_ip, int server_port) {
         return false;
     }
 
+    if (!this->merge_executor_started_) {
+        merge_executor_init(&this->merge_executor_, this->merge_threads_, this->merge_mode_, this->simplify_merges_);
+        this->merge_executor_started_ = true;
+    }
     return true;
 }
 
@@ -67,14 +151,59 @@ void bdd_klient_disconnect(bdd_klient *this) {
     this->server_socket_ = 0;
 }
 
+static void* bdd_klient_receive_modules_thread(void* args) {
+    bdd_klient_receive_modules((bdd_klient*)args);
+    return NULL;
+}
+
 _Bool bdd_klient_receive_info(bdd_klient *this) {
     if (!bdd_klient_receive_instructions(this)) {
         return false;
     }
-    bdd_klient_receive_modules(this);
+    bdd_klient_negotiate_compression(this);
+    bdd_klient_receive_merge_mode(this);
+    // In the dynamic mode every task is followed by its own modules.
+    if (strncmp(this->instructions, "DYNM", 4) == 0) {
+        return true;
+    }
+    // Set before peer_receiver_ starts, it must not read the server socket until the own modules are received.
+    this->receiving_ = true;
+    bdd_klient_exchange_peers(this);
+    this->receiver_started_ = true;
+    pthread_create(&this->receiver_, NULL, bdd_klient_receive_modules_thread, this);
     return true;
 }
 
+void bdd_klient_negotiate_compression(bdd_klient *this) {
+    int accepts = this->compress_transfers_;
+    bdd_message msg;
+    bdd_message_init(&msg, -1);
+    bdd_message_set_payload(&msg, &accepts, sizeof(int));
+    bdd_message_serialize(&msg, serialize_int);
+    bdd_klient_send_message(this, &msg);
+    bdd_message_destroy(&msg);
+
+    bdd_message_init(&msg, this->server_socket_);
+    bdd_klient_receive_message(this, &msg);
+    bdd_message_deserialize(&msg, deserialize_string);
+    free(this->compressed_receivers_);
+    this->compressed_receivers_ = bdd_message_get_unique_payload(&msg);
+    bdd_message_destroy(&msg);
+}
+
+void bdd_klient_receive_merge_mode(bdd_klient *this) {
+    bdd_message msg;
+    bdd_message_init(&msg, this->server_socket_);
+    bdd_klient_receive_message(this, &msg);
+    bdd_message_deserialize(&msg, deserialize_int);
+    int* mode = bdd_message_get_payload(&msg);
+    this->merge_mode_ = MODULE_MERGE_CUBES;
+    if (mode && *mode >= MODULE_MERGE_CUBES && *mode <= MODULE_MERGE_BDD) {
+        this->merge_mode_ = *mode;
+    }
+    bdd_message_destroy(&msg);
+}
+
 bool bdd_klient_receive_instructions(bdd_klient *this) {
     bdd_message msg;
     bdd_message_init(&msg, this->server_socket_);
@@ -85,6 +214,175 @@ bool bdd_klient_receive_instructions(bdd_klient *this) {
     return strcmp(this->instructions, "Client closing") != 0;
 }
 
+static void* bdd_klient_receive_peers_thread(void* args) {
+    bdd_klient* this = args;
+    pthread_mutex_lock(&this->modules_mutex_);
+    int pending = this->pending_peer_modules_;
+    pthread_mutex_unlock(&this->modules_mutex_);
+
+    // Every module of another client comes on a connection of its own, or through the server
+    // when the sender could not reach this client. The server socket is read once receiver_ is done.
+    while (pending > 0) {
+        pthread_mutex_lock(&this->modules_mutex_);
+        _Bool receiving = this->receiving_;
+        pthread_mutex_unlock(&this->modules_mutex_);
+
+        struct pollfd sockets[2];
+        sockets[0].fd = this->peer_socket_;
+        sockets[0].events = POLLIN;
+        sockets[1].fd = receiving ? -1 : this->server_socket_;
+        sockets[1].events = POLLIN;
+        sockets[0].revents = sockets[1].revents = 0;
+        if (poll(sockets, 2, receiving ? BDD_KLIENT_PEER_POLL_INTERVAL : -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Chyba pri čakaní na moduly od klientov");
+            break;
+        }
+
+        bdd_message message;
+        bdd_message_init(&message, 0);
+        _Bool received = false;
+        module* mod = NULL;
+        if (sockets[1].revents) {
+            if (!bdd_klient_receive_message_from(this->server_socket_, &message)) {
+                printf("Server sa odpojil.\n");
+                bdd_message_destroy(&message);
+                break;
+            }
+            bdd_message_deserialize_in_place(&message, module_deserialize_in_place);
+            mod = bdd_message_get_unique_payload(&message);
+            received = true;
+        } else if (sockets[0].revents) {
+            int peer_fd = accept(this->peer_socket_, NULL, NULL);
+            if (peer_fd == -1) {
+                bdd_message_destroy(&message);
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("Chyba pri prijímaní spojenia od klienta");
+                break;
+            }
+            // The module counts as received only once the sender got the acknowledgement,
+            // a sender without it sends the module through the server instead.
+            if (bdd_klient_receive_message_from(peer_fd, &message)) {
+                bdd_message_deserialize_in_place(&message, module_deserialize_in_place);
+                mod = bdd_message_get_unique_payload(&message);
+            }
+            char ack = BDD_KLIENT_PEER_ACK;
+            if (mod && send_all(peer_fd, &ack, sizeof(ack)) > 0) {
+                received = true;
+            } else {
+                printf("Nepodarilo sa prijať modul od klienta, odosielateľ ho pošle cez server.\n");
+                if (mod) {
+                    module_destroy_array_list(&mod);
+                    mod = NULL;
+                }
+            }
+            close(peer_fd);
+        }
+        bdd_message_destroy(&message);
+        if (!received) {
+            continue;
+        }
+
+        pthread_mutex_lock(&this->modules_mutex_);
+        if (mod) {
+            array_list_add(&this->modules_, &mod);
+            hash_map_put(&this->module_index_, module_get_name(mod), mod);
+        }
+        pending = --this->pending_peer_modules_;
+        pthread_cond_broadcast(&this->module_received_);
+        pthread_mutex_unlock(&this->modules_mutex_);
+    }
+
+    pthread_mutex_lock(&this->modules_mutex_);
+    this->pending_peer_modules_ = 0;
+    pthread_cond_broadcast(&this->module_received_);
+    pthread_mutex_unlock(&this->modules_mutex_);
+    return NULL;
+}
+
+static int bdd_klient_open_peer_socket(bdd_klient *this, int backlog) {
+    this->peer_socket_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (this->peer_socket_ == -1) {
+        perror("Chyba pri vytváraní socketu pre klientov");
+        return 0;
+    }
+
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = 0;
+    if (bind(this->peer_socket_, (struct sockaddr*)&address, sizeof(address)) == -1 ||
+        listen(this->peer_socket_, backlog) == -1 ||
+        getsockname(this->peer_socket_, (struct sockaddr*)&address, &address_length) == -1) {
+        perror("Chyba pri otváraní socketu pre klientov");
+        close(this->peer_socket_);
+        this->peer_socket_ = -1;
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
+
+void bdd_klient_exchange_peers(bdd_klient *this) {
+    int recv_count = 0;
+    for (char* line = this->instructions; line && *line; line = strchr(line, '\n'), line = line ? line + 1 : NULL) {
+        recv_count += strncmp(line, "RECV", 4) == 0;
+    }
+    int port = recv_count > 0 ? bdd_klient_open_peer_socket(this, recv_count) : 0;
+
+    bdd_message msg;
+    bdd_message_init(&msg, -1);
+    bdd_message_set_payload(&msg, &port, sizeof(int));
+    bdd_message_serialize(&msg, serialize_int);
+    bdd_klient_send_message(this, &msg);
+    bdd_message_destroy(&msg);
+
+    bdd_message_init(&msg, this->server_socket_);
+    bdd_klient_receive_message(this, &msg);
+    bdd_message_deserialize(&msg, deserialize_string);
+    char* table = bdd_message_get_unique_payload(&msg);
+    bdd_message_destroy(&msg);
+
+    int client_id;
+    char address[INET_ADDRSTRLEN];
+    int peer_port;
+    int offset = 0;
+    int read = 0;
+    while (table && sscanf(table + offset, "%d %15s %d\n%n", &client_id, address, &peer_port, &read) == 3) {
+        offset += read;
+        if (client_id < 0) {
+            continue;
+        }
+        if (client_id >= this->peer_count_) {
+            this->peers_ = realloc(this->peers_, (client_id + 1) * sizeof(struct sockaddr_in));
+            memset(this->peers_ + this->peer_count_, 0, (client_id + 1 - this->peer_count_) * sizeof(struct sockaddr_in));
+            this->peer_count_ = client_id + 1;
+        }
+        this->peers_[client_id].sin_family = AF_INET;
+        this->peers_[client_id].sin_port = htons(peer_port);
+        if (inet_pton(AF_INET, address, &this->peers_[client_id].sin_addr) != 1) {
+            this->peers_[client_id].sin_port = 0;
+        }
+    }
+    free(table);
+
+    // Without the table other clients send through the server, RECV then reads from it.
+    if (!this->peers_ && this->peer_socket_ >= 0) {
+        close(this->peer_socket_);
+        this->peer_socket_ = -1;
+    }
+    if (this->peer_socket_ >= 0) {
+        this->pending_peer_modules_ = recv_count;
+        this->peer_receiver_started_ = true;
+        pthread_create(&this->peer_receiver_, NULL, bdd_klient_receive_peers_thread, this);
+    }
+}
+
 void bdd_klient_receive_modules(bdd_klient *this) {
     bdd_message message;
     bdd_message_init(&message, this->server_socket_);
@@ -96,18 +394,39 @@ void bdd_klient_receive_modules(bdd_klient *this) {
 
     for (int i = 0; i < module_count; i++) {
         bdd_klient_receive_message(this, &message);
-        bdd_message_deserialize(&message, module_deserialize);
+        bdd_message_deserialize_in_place(&message, module_deserialize_in_place);
         module* result = bdd_message_get_unique_payload(&message);
+        pthread_mutex_lock(&this->modules_mutex_);
         array_list_add(&this->modules_, &result);
+        hash_map_put(&this->module_index_, module_get_name(result), result);
+        pthread_cond_broadcast(&this->module_received_);
+        pthread_mutex_unlock(&this->modules_mutex_);
         bdd_message_clear_buffer(&message);
     }
+    bdd_message_destroy(&message);
 
+    pthread_mutex_lock(&this->modules_mutex_);
+    this->receiving_ = false;
+    pthread_cond_broadcast(&this->module_received_);
+    pthread_mutex_unlock(&this->modules_mutex_);
+}
+
+void bdd_klient_wait_for_modules(bdd_klient *this) {
+    if (this->receiver_started_) {
+        pthread_join(this->receiver_, NULL);
+        this->receiver_started_ = false;
+    }
 }
 
 module* bdd_klient_get_module(bdd_klient* this, char* module_name) {
-    module* temp = NULL;
-    array_list_find_by_property(&this->modules_, &temp, module_match_name, module_name);
-    return temp;
+    pthread_mutex_lock(&this->modules_mutex_);
+    module* result = hash_map_get(&this->module_index_, module_name);
+    while (!result && (this->receiving_ || this->pending_peer_modules_ > 0)) {
+        pthread_cond_wait(&this->module_received_, &this->modules_mutex_);
+        result = hash_map_get(&this->module_index_, module_name);
+    }
+    pthread_mutex_unlock(&this->modules_mutex_);
+    return result;
 }
 
 void bdd_klient_merge_modules(bdd_klient *this, char *instruction) {
@@ -117,22 +436,72 @@ void bdd_klient_merge_modules(bdd_klient *this, char *instruction) {
         sscanf(instruction, "MERG %ms %ms", &parent_name, &son_name);
         module* parent = bdd_klient_get_module(this, parent_name);
         module* son = bdd_klient_get_module(this, son_name);
-        module_merge_modules(parent, son);
+        if (parent && son) {
+            merge_executor_add_merge(&this->merge_executor_, parent, son);
+        } else {
+            printf("Nepodarilo sa spojiť moduly %s a %s.\n", parent_name, son_name);
+        }
         free(son_name);
         free(parent_name);
     }
 }
 
+void bdd_klient_flush_merges(bdd_klient *this, module *parent) {
+    merge_executor_wait(&this->merge_executor_, parent);
+}
+
+void bdd_klient_flush_all_merges(bdd_klient *this) {
+    merge_executor_wait_all(&this->merge_executor_);
+}
+
+/**
+ * @brief Connects to the socket another client listens on, retrying while it is not ready yet.
+ * @return Socket descriptor of the connection, or -1.
+ */
+static int bdd_klient_connect_peer(bdd_klient *this, int client_id) {
+    for (int attempt = 0; attempt < BDD_KLIENT_PEER_CONNECT_ATTEMPTS; attempt++) {
+        if (attempt > 0) {
+            usleep(BDD_KLIENT_PEER_CONNECT_DELAY);
+        }
+        int peer_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (peer_fd == -1) {
+            return -1;
+        }
+        if (connect(peer_fd, (struct sockaddr*)&this->peers_[client_id], sizeof(struct sockaddr_in)) == 0) {
+            return peer_fd;
+        }
+        close(peer_fd);
+    }
+    return -1;
+}
+
 void bdd_klient_send_instruction(bdd_klient * this, char * instruction) {
     char* module_name = NULL;
     int client_id = 0;
     sscanf(instruction, "SEND %ms %d", &module_name, &client_id);
     module* mod = bdd_klient_get_module(this, module_name);
+    bdd_klient_flush_merges(this, mod);
     bdd_message msg;
     bdd_message_init(&msg, client_id);
     bdd_message_set_payload(&msg, &mod, sizeof(module*));
-    bdd_message_serialize(&msg, module_serialize);
-    bdd_klient_send_message(this, &msg);
+    bdd_message_serialize_direct(&msg, module_write);
+    bdd_klient_compress_module(this, &msg, client_id);
+
+    // A client listening for other clients also reads the modules its senders could not send directly.
+    _Bool sent = false;
+    if (client_id >= 0 && client_id < this->peer_count_ && this->peers_[client_id].sin_port != 0) {
+        int peer_fd = bdd_klient_connect_peer(this, client_id);
+        if (peer_fd != -1) {
+            sent = bdd_klient_send_message_to(peer_fd, &msg) && bdd_klient_receive_peer_ack(peer_fd);
+            close(peer_fd);
+        }
+        if (!sent) {
+            printf("Modul %s sa klientovi %d posiela cez server.\n", module_name, client_id);
+        }
+    }
+    if (!sent) {
+        bdd_klient_send_message(this, &msg);
+    }
     bdd_message_destroy(&msg);
     free(module_name);
 }
@@ -140,15 +509,29 @@ void bdd_klient_send_instruction(bdd_klient * this, char * instruction) {
 void bdd_klient_recv_instruction(bdd_klient * this, char * instruction) {
     char* module_name = NULL;
     sscanf(instruction, "RECV %ms", &module_name);
+    if (this->peer_socket_ >= 0) {
+        if (!bdd_klient_get_module(this, module_name)) {
+            printf("Nepodarilo sa prijať modul %s.\n", module_name);
+        }
+        free(module_name);
+        return;
+    }
+    bdd_klient_wait_for_modules(this);
     bdd_message msg;
     bdd_message_init(&msg, this->server_socket_);
-    bdd_klient_receive_message(this, &msg);
-    bdd_message_deserialize(&msg, module_deserialize);
-    module* mod = bdd_message_get_unique_payload(&msg);
-    if (strcmp(module_name, module_get_name(mod)) != 0) {
-        printf("Received bad module!! Got %s instead of %s\n", module_get_name(mod), module_name);
+    // Modules from different senders can arrive in any order, the ones received early wait for their RECV.
+    while (!bdd_klient_get_module(this, module_name)) {
+        bdd_klient_receive_message(this, &msg);
+        bdd_message_deserialize_in_place(&msg, module_deserialize_in_place);
+        module* mod = bdd_message_get_unique_payload(&msg);
+        if (!mod) {
+            printf("Nepodarilo sa prijať modul %s.\n", module_name);
+            break;
+        }
+        array_list_add(&this->modules_, &mod);
+        hash_map_put(&this->module_index_, module_get_name(mod), mod);
+        bdd_message_clear_buffer(&msg);
     }
-    array_list_add(&this->modules_, &mod);
     bdd_message_destroy(&msg);
     free(module_name);
 }
@@ -157,10 +540,36 @@ void bdd_klient_end_instruction(bdd_klient * this, char * instruction) {
     char* module_name = NULL;
     sscanf(instruction, "END %ms", &module_name);
     module* mod = bdd_klient_get_module(this, module_name);
+    bdd_klient_flush_merges(this, mod);
+    // The receiver must be done with the server socket before the result is written to it.
+    bdd_klient_wait_for_modules(this);
     bdd_message msg;
     bdd_message_init(&msg, -2);
     bdd_message_set_payload(&msg, &mod, sizeof(module*));
-    bdd_message_serialize(&msg, module_serialize);
+    bdd_message_serialize_direct(&msg, module_write);
+    bdd_klient_compress_module(this, &msg, -2);
+    bdd_klient_send_message(this, &msg);
+    bdd_message_destroy(&msg);
+    free(module_name);
+}
+
+void bdd_klient_done_instruction(bdd_klient *this, char *instruction) {
+    char* module_name = NULL;
+    sscanf(instruction, "%*s %ms", &module_name);
+    module* mod = bdd_klient_get_module(this, module_name);
+    bdd_klient_flush_merges(this, mod);
+    bdd_message msg;
+    if (strncmp(instruction, "UPLD", 4) == 0) {
+        bdd_message_init(&msg, BDD_MESSAGE_TASK_UPLOAD);
+        bdd_message_set_payload(&msg, &mod, sizeof(module*));
+        bdd_message_serialize_direct(&msg, module_write);
+        bdd_klient_compress_module(this, &msg, BDD_MESSAGE_TASK_UPLOAD);
+    } else {
+        int temp = 0;
+        bdd_message_init(&msg, BDD_MESSAGE_TASK_DONE);
+        bdd_message_set_payload(&msg, &temp, sizeof(int));
+        bdd_message_serialize(&msg, serialize_int);
+    }
     bdd_klient_send_message(this, &msg);
     bdd_message_destroy(&msg);
     free(module_name);
@@ -176,37 +585,74 @@ void bdd_klient_finish_instruction(bdd_klient *this) {
     bdd_message_destroy(&msg);
 }
 
-void bdd_klient_execute_instructions(bdd_klient *this, void(*execute_instruction)(bdd_klient *bdd_klient_, char *instruction)) {
-    FILE *stream = fmemopen(this->instructions, strlen(this->instructions), "r");
+static _Bool bdd_klient_run_script(bdd_klient *this, char *script, void(*execute_instruction)(bdd_klient *bdd_klient_, char *instruction)) {
+    FILE *stream = fmemopen(script, strlen(script), "r");
     if (!stream) {
         perror("Failed to open memory stream");
-        return;
+        return false;
     }
 
+    merge_executor_reset(&this->merge_executor_, this->merge_mode_, this->simplify_merges_);
+    merge_executor_plan(&this->merge_executor_, script);
+
     char *line = NULL;
     size_t len = 0;
+    _Bool ended = false;
 
-    while (getline(&line, &len, stream) != -1) {
+    while (!ended && getline(&line, &len, stream) != -1) {
         line[strcspn(line, "\n")] = '\0';
 
         if (strncmp(line, "SEND", 4) == 0) {
             bdd_klient_send_instruction(this, line);
         } else if (strncmp(line, "RECV", 4) == 0) {
             bdd_klient_recv_instruction(this, line);
+        } else if (strncmp(line, "DONE", 4) == 0 || strncmp(line, "UPLD", 4) == 0) {
+            bdd_klient_done_instruction(this, line);
         } else if (strncmp(line, "END", 3) == 0) {
             bdd_klient_end_instruction(this, line);
-            free(line);
-            fclose(stream);
-            return;
+            ended = true;
         } else {
             execute_instruction(this, line);
         }
     }
-    
-    bdd_klient_finish_instruction(this);
+
+    bdd_klient_flush_all_merges(this);
 
     free(line);
     fclose(stream);
+    return ended;
+}
+
+void bdd_klient_execute_instructions(bdd_klient *this, void(*execute_instruction)(bdd_klient *bdd_klient_, char *instruction)) {
+    if (strncmp(this->instructions, "DYNM", 4) == 0) {
+        bdd_klient_execute_tasks(this, execute_instruction);
+        return;
+    }
+
+    _Bool ended = bdd_klient_run_script(this, this->instructions, execute_instruction);
+    bdd_klient_wait_for_modules(this);
+    if (!ended) {
+        bdd_klient_finish_instruction(this);
+    }
+}
+
+void bdd_klient_execute_tasks(bdd_klient *this, void(*execute_instruction)(bdd_klient *bdd_klient_, char *instruction)) {
+    _Bool ended = false;
+    while (!ended) {
+        bdd_message msg;
+        bdd_message_init(&msg, this->server_socket_);
+        bdd_klient_receive_message(this, &msg);
+        bdd_message_deserialize(&msg, deserialize_string);
+        char* script = bdd_message_get_unique_payload(&msg);
+        bdd_message_destroy(&msg);
+
+        if (!script || strcmp(script, "Client closing") == 0) {
+            free(script);
+            return;
+        }
+        ended = bdd_klient_run_script(this, script, execute_instruction);
+        free(script);
+    }
 }
 
 void bdd_klient_print_modules(bdd_klient *this) {
@@ -221,6 +667,15 @@ void bdd_klient_print_instructions(bdd_klient *this) {
     printf("%s\n", this->instructions);
 }
 
+void bdd_klient_print_compression(bdd_klient *this) {
+    if (!this->compress_transfers_ || this->transfer_sent_bytes_ == 0) {
+        return;
+    }
+    printf("Odoslané moduly: %zu B, po kompresii %zu B (kompresný pomer %.2f).\n",
+           this->transfer_raw_bytes_, this->transfer_sent_bytes_,
+           (double)this->transfer_raw_bytes_ / (double)this->transfer_sent_bytes_);
+}
+
 bool bdd_klient_test_connection(bdd_klient *this) {
     char buf;
     ssize_t ret = recv(this->server_socket_, &buf, 1, MSG_PEEK | MSG_DONTWAIT);
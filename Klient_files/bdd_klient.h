@@ -2,19 +2,86 @@
 #define BDD_KLIENT_H
 #include "../Shared/bdd_message.h"
 #include "../Shared/array_list.h"
+#include "../Shared/hash_map.h"
 #include "../Shared/module.h"
+#include "merge_executor.h"
+#include <pthread.h>
+#include <arpa/inet.h>
+
+/**
+ * @brief Number of attempts to connect to another client before its module is sent through the server.
+ */
+#define BDD_KLIENT_PEER_CONNECT_ATTEMPTS 5
+
+/**
+ * @brief Delay between the attempts to connect to another client in microseconds.
+ */
+#define BDD_KLIENT_PEER_CONNECT_DELAY 100000
+
+/**
+ * @brief Byte a client sends back on a peer connection once it has received and read the module.
+ */
+#define BDD_KLIENT_PEER_ACK 'A'
+
+/**
+ * @brief Interval in milliseconds in which peer_receiver_ checks whether receiver_ is done with the server socket.
+ */
+#define BDD_KLIENT_PEER_POLL_INTERVAL 100
 
 /**
  * @brief Represents a client connected to a BDD server.
  *
  * Fields:
  * - modules_: List of modules managed by the client.
+ * - module_index_: Hash map from module names to the modules in modules_.
+ * - merge_executor_: Runs the merges of the instructions being executed, started on connect and stopped by bdd_klient_clear_klient.
+ * - merge_executor_started_: Whether merge_executor_ was started and not destroyed yet.
+ * - merge_threads_: Number of threads merging modules.
  * - server_socket_: Socket descriptor for the server connection.
+ * - simplify_merges_: Whether merged functions are simplified after each merge.
+ * - merge_mode_: Way of merging son functions, see module_merge_sons, received from the server in every run.
+ * - receiver_: Thread receiving the initial modules while instructions run.
+ * - modules_mutex_: Mutex guarding modules_ and module_index_ while receiver_ runs.
+ * - module_received_: Signaled when receiver_ adds a module or finishes.
+ * - receiving_: Whether receiver_ still receives modules, guarded by modules_mutex_.
+ * - receiver_started_: Whether receiver_ was started and not joined yet.
+ * - peer_socket_: Socket other clients send modules to, or -1.
+ * - peers_: Addresses of the other clients by client ID, port 0 when unknown, or NULL when modules go through the server.
+ * - peer_count_: Number of addresses in peers_.
+ * - peer_receiver_: Thread receiving modules sent by other clients, directly or through the server.
+ * - pending_peer_modules_: Number of modules peer_receiver_ still receives, guarded by modules_mutex_.
+ * - peer_receiver_started_: Whether peer_receiver_ was started and not joined yet.
+ * - compress_transfers_: Whether the client sends and accepts compressed modules.
+ * - compressed_receivers_: Acceptance of compressed modules from the server, '1' at index 0 for the server
+ *   and at index i + 1 for client i, or NULL before bdd_klient_negotiate_compression.
+ * - transfer_raw_bytes_: Size of the modules sent in this run before compression.
+ * - transfer_sent_bytes_: Size of the modules sent in this run as sent.
  * - instructions: String containing the client's instructions.
  */
 typedef struct bdd_klient {
     array_list modules_;
+    hash_map module_index_;
+    merge_executor merge_executor_;
+    _Bool merge_executor_started_;
+    int merge_threads_;
     int server_socket_;
+    _Bool simplify_merges_;
+    module_merge_mode merge_mode_;
+    pthread_t receiver_;
+    pthread_mutex_t modules_mutex_;
+    pthread_cond_t module_received_;
+    _Bool receiving_;
+    _Bool receiver_started_;
+    int peer_socket_;
+    struct sockaddr_in* peers_;
+    int peer_count_;
+    pthread_t peer_receiver_;
+    int pending_peer_modules_;
+    _Bool peer_receiver_started_;
+    _Bool compress_transfers_;
+    char* compressed_receivers_;
+    size_t transfer_raw_bytes_;
+    size_t transfer_sent_bytes_;
     char* instructions;
 } bdd_klient;
 
@@ -66,12 +133,35 @@ void bdd_klient_send_message(bdd_klient *this, bdd_message *message);
 void bdd_klient_receive_message(bdd_klient *this, bdd_message *message);
 
 /**
- * @brief Receives instructions and modules from the server.
+ * @brief Receives instructions from the server and starts receiving modules.
+ *
+ * The modules are received by a background thread, so instructions can run
+ * as soon as their modules arrive, see bdd_klient_get_module. Modules from
+ * other clients are received directly from them when the server allows it,
+ * see bdd_klient_exchange_peers.
  * @param this Pointer to the client instance.
  * @return true if successful, false otherwise.
  */
 _Bool bdd_klient_receive_info(bdd_klient *this);
 
+/**
+ * @brief Agrees with the server on which connections carry compressed modules.
+ *
+ * The client tells the server whether it accepts compressed modules and
+ * receives which of the server and the other clients do. A module is
+ * compressed only if both its sender and its receiver accept it.
+ * @param this Pointer to the client instance.
+ */
+void bdd_klient_negotiate_compression(bdd_klient *this);
+
+/**
+ * @brief Receives the way of merging son functions the server chose for this run.
+ *
+ * A value the client does not know leaves MODULE_MERGE_CUBES in place.
+ * @param this Pointer to the client instance.
+ */
+void bdd_klient_receive_merge_mode(bdd_klient *this);
+
 /**
  * @brief Receives instructions from the server.
  * @param this Pointer to the client instance.
@@ -79,14 +169,34 @@ _Bool bdd_klient_receive_info(bdd_klient *this);
  */
 bool bdd_klient_receive_instructions(bdd_klient *this);
 
+/**
+ * @brief Exchanges the addresses of the clients with the server.
+ *
+ * A client with RECV instructions listens for the modules of other clients
+ * and starts peer_receiver_, unless the server relays modules itself.
+ * @param this Pointer to the client instance.
+ */
+void bdd_klient_exchange_peers(bdd_klient *this);
+
 /**
  * @brief Receives modules from the server.
  * @param this Pointer to the client instance.
  */
 void bdd_klient_receive_modules(bdd_klient *this);
 
+/**
+ * @brief Waits until the initial modules are received.
+ *
+ * Must be called before anything else reads from the server socket.
+ * @param this Pointer to the client instance.
+ */
+void bdd_klient_wait_for_modules(bdd_klient *this);
+
 /**
  * @brief Finds and retrieves a module by name.
+ *
+ * Waits for the module while the initial modules or modules from other
+ * clients are still being received.
  * @param this Pointer to the client instance.
  * @param module_name Name of the module to retrieve.
  * @return Pointer to the found module, or NULL if not found.
@@ -95,13 +205,33 @@ module* bdd_klient_get_module(bdd_klient* this, char* module_name);
 
 /**
  * @brief Merges two modules based on an instruction.
+ *
+ * The merge runs on merge_executor_ once all sons of the parent were
+ * added and merged, see merge_executor_add_merge.
  * @param this Pointer to the client instance.
  * @param instruction Instruction specifying the merge operation.
  */
 void bdd_klient_merge_modules(bdd_klient *this, char *instruction);
 
+/**
+ * @brief Waits until all merges into a parent finish.
+ *
+ * The merged function is simplified afterwards if simplify_merges_ is set.
+ * @param this Pointer to the client instance.
+ * @param parent Pointer to the parent module.
+ */
+void bdd_klient_flush_merges(bdd_klient *this, module *parent);
+
+/**
+ * @brief Waits until all merges finish.
+ * @param this Pointer to the client instance.
+ */
+void bdd_klient_flush_all_merges(bdd_klient *this);
+
 /**
  * @brief Sends a module to another client based on an instruction.
+ *
+ * A module for a client that cannot be reached directly is sent through the server.
  * @param this Pointer to the client instance.
  * @param instruction Instruction specifying the operation.
  */
@@ -121,6 +251,15 @@ void bdd_klient_recv_instruction(bdd_klient *this, char *instruction);
  */
 void bdd_klient_end_instruction(bdd_klient *this, char *instruction);
 
+/**
+ * @brief Reports a finished task to the server based on an instruction.
+ *
+ * "UPLD module" uploads the merged module, "DONE module" keeps it on the client.
+ * @param this Pointer to the client instance.
+ * @param instruction Instruction specifying the operation.
+ */
+void bdd_klient_done_instruction(bdd_klient *this, char *instruction);
+
 /**
  * @brief Sends a finish signal to the server.
  * @param this Pointer to the client instance.
@@ -134,12 +273,28 @@ void bdd_klient_finish_instruction(bdd_klient *this);
  */
 void bdd_klient_execute_instructions(bdd_klient *this, void(*execute_instruction)(bdd_klient *bdd_klient_, char *instruction));
 
+/**
+ * @brief Executes merge tasks handed out by the server until it has none left.
+ *
+ * Used when the instructions are "DYNM", every task is a script of its own
+ * followed by the modules it receives.
+ * @param this Pointer to the client instance.
+ * @param execute_instruction Callback function to handle specific instructions.
+ */
+void bdd_klient_execute_tasks(bdd_klient *this, void(*execute_instruction)(bdd_klient *bdd_klient_, char *instruction));
+
 /**
  * @brief Prints the modules managed by the client.
  * @param this Pointer to the client instance.
  */
 void bdd_klient_print_modules(bdd_klient *this);
 
+/**
+ * @brief Prints how much the compression reduced the modules sent in this run.
+ * @param this Pointer to the client instance.
+ */
+void bdd_klient_print_compression(bdd_klient *this);
+
 /**
  * @brief Prints the instructions received by the client.
  * @param this Pointer to the client instance.
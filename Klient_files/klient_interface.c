@@ -35,6 +35,14 @@ void klient_interface_start_interface(klient_interface *this) {
             case 4:
                 klient_interface_run(this);
                 break;
+            case 5:
+                this->klient_.simplify_merges_ = !this->klient_.simplify_merges_;
+                printf("Zjednodušovanie funkcií po spájaní je %s.\n", this->klient_.simplify_merges_ ? "zapnuté" : "vypnuté");
+                break;
+            case 6:
+                this->klient_.compress_transfers_ = !this->klient_.compress_transfers_;
+                printf("Kompresia prenášaných modulov je %s.\n", this->klient_.compress_transfers_ ? "zapnutá" : "vypnutá");
+                break;
             default:
                 printf("Zadali ste neplatnú možnosť, zadajte znovu.\n");
                 break;
@@ -50,6 +58,8 @@ void klient_interface_print_menu(void) {
     printf("2 - Odpojiť sa od servera\n");
     printf("3 - Otestovať spojenie\n");
     printf("4 - Spustiť inštrukcie\n");
+    printf("5 - Zapnúť/vypnúť zjednodušovanie funkcií po spájaní\n");
+    printf("6 - Zapnúť/vypnúť kompresiu prenášaných modulov\n");
     printf("0 - Ukončiť\n");
     printf("Vyberte možnosť: ");
 }
@@ -118,6 +128,7 @@ void klient_interface_run(klient_interface *this) {
     if (bdd_klient_receive_info(&this->klient_)) {
         printf("Klient vykonáva výpočet...\n");
         bdd_klient_execute_instructions(&this->klient_, bdd_klient_merge_modules);
+        bdd_klient_print_compression(&this->klient_);
         printf("Klient svoju časť dokončil. Odpája sa od servera.\n");
     } else {
         printf("Tento klient sa nebude používať, server ukončuje spojenie.\n");
@@ -0,0 +1,198 @@
+#include "merge_executor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static merge_task* merge_executor_get_task(merge_executor* this, const char* name) {
+    merge_task* task = hash_map_get(&this->tasks_, name);
+    if (!task) {
+        task = malloc(sizeof(merge_task));
+        task->name_ = strdup(name);
+        task->parent_ = NULL;
+        array_list_init(&task->sons_, sizeof(module*));
+        task->expected_sons_ = 0;
+        task->waiting_sons_ = 0;
+        task->dependent_ = NULL;
+        task->complete_ = false;
+        task->done_ = false;
+        hash_map_put(&this->tasks_, task->name_, task);
+        array_list_add(&this->all_tasks_, &task);
+    }
+    return task;
+}
+
+static void merge_executor_release(merge_executor* this, merge_task* task) {
+    if (task->complete_) {
+        return;
+    }
+    task->complete_ = true;
+    if (task->waiting_sons_ == 0) {
+        array_list_add(&this->ready_, &task);
+        pthread_cond_signal(&this->task_ready_);
+    }
+}
+
+static void* merge_executor_worker(void* args) {
+    merge_executor* this = args;
+
+    pthread_mutex_lock(&this->mutex_);
+    while (true) {
+        while (!this->stopping_ && array_list_get_size(&this->ready_) == 0) {
+            pthread_cond_wait(&this->task_ready_, &this->mutex_);
+        }
+        if (array_list_get_size(&this->ready_) == 0) {
+            break;
+        }
+        merge_task* task = NULL;
+        array_list_try_get(&this->ready_, array_list_get_size(&this->ready_) - 1, &task);
+        array_list_remove_last(&this->ready_);
+        pthread_mutex_unlock(&this->mutex_);
+
+        int son_count = array_list_get_size(&task->sons_);
+        if (son_count > 0) {
+            module** sons = malloc(son_count * sizeof(module*));
+            for (int i = 0; i < son_count; i++) {
+                array_list_try_get(&task->sons_, i, sons + i);
+            }
+            module_merge_sons(task->parent_, sons, son_count, this->merge_mode_);
+            if (this->simplify_) {
+                pla_function_simplify(module_get_function(task->parent_));
+            }
+            free(sons);
+        }
+
+        pthread_mutex_lock(&this->mutex_);
+        task->done_ = true;
+        merge_task* dependent = task->dependent_;
+        if (dependent && --dependent->waiting_sons_ == 0 && dependent->complete_) {
+            array_list_add(&this->ready_, &dependent);
+            pthread_cond_signal(&this->task_ready_);
+        }
+        pthread_cond_broadcast(&this->task_done_);
+    }
+    pthread_mutex_unlock(&this->mutex_);
+    return NULL;
+}
+
+static void merge_executor_free_tasks(merge_executor* this) {
+    for (int i = 0; i < array_list_get_size(&this->all_tasks_); i++) {
+        merge_task* task = NULL;
+        array_list_try_get(&this->all_tasks_, i, &task);
+        array_list_destroy(&task->sons_);
+        free(task->name_);
+        free(task);
+    }
+}
+
+void merge_executor_init(merge_executor *this, int thread_count, module_merge_mode merge_mode, _Bool simplify) {
+    hash_map_init(&this->tasks_);
+    array_list_init(&this->all_tasks_, sizeof(merge_task*));
+    array_list_init(&this->ready_, sizeof(merge_task*));
+    pthread_mutex_init(&this->mutex_, NULL);
+    pthread_cond_init(&this->task_ready_, NULL);
+    pthread_cond_init(&this->task_done_, NULL);
+    this->stopping_ = false;
+    this->merge_mode_ = merge_mode;
+    this->simplify_ = simplify;
+
+    this->thread_count_ = thread_count > 0 ? thread_count : 1;
+    this->threads_ = malloc(this->thread_count_ * sizeof(pthread_t));
+    for (int i = 0; i < this->thread_count_; i++) {
+        pthread_create(this->threads_ + i, NULL, merge_executor_worker, this);
+    }
+}
+
+void merge_executor_destroy(merge_executor *this) {
+    pthread_mutex_lock(&this->mutex_);
+    this->stopping_ = true;
+    pthread_cond_broadcast(&this->task_ready_);
+    pthread_mutex_unlock(&this->mutex_);
+    for (int i = 0; i < this->thread_count_; i++) {
+        pthread_join(this->threads_[i], NULL);
+    }
+    free(this->threads_);
+    this->threads_ = NULL;
+    this->thread_count_ = 0;
+
+    merge_executor_free_tasks(this);
+    array_list_destroy(&this->all_tasks_);
+    array_list_destroy(&this->ready_);
+    hash_map_destroy(&this->tasks_);
+    pthread_cond_destroy(&this->task_done_);
+    pthread_cond_destroy(&this->task_ready_);
+    pthread_mutex_destroy(&this->mutex_);
+}
+
+void merge_executor_reset(merge_executor *this, module_merge_mode merge_mode, _Bool simplify) {
+    pthread_mutex_lock(&this->mutex_);
+    merge_executor_free_tasks(this);
+    array_list_clear(&this->all_tasks_);
+    array_list_clear(&this->ready_);
+    hash_map_clear(&this->tasks_);
+    this->merge_mode_ = merge_mode;
+    this->simplify_ = simplify;
+    pthread_mutex_unlock(&this->mutex_);
+}
+
+void merge_executor_plan(merge_executor *this, const char *instructions) {
+    pthread_mutex_lock(&this->mutex_);
+    const char* line = instructions;
+    while (line && *line) {
+        char parent_name[256];
+        if (strncmp(line, "MERG", 4) == 0 && sscanf(line, "MERG %255s", parent_name) == 1) {
+            merge_executor_get_task(this, parent_name)->expected_sons_++;
+        }
+        line = strchr(line, '\n');
+        if (line) {
+            line++;
+        }
+    }
+    pthread_mutex_unlock(&this->mutex_);
+}
+
+void merge_executor_add_merge(merge_executor *this, module *parent, module *son) {
+    pthread_mutex_lock(&this->mutex_);
+    merge_task* task = merge_executor_get_task(this, module_get_name(parent));
+    task->parent_ = parent;
+    array_list_add(&task->sons_, &son);
+
+    merge_task* son_task = hash_map_get(&this->tasks_, module_get_name(son));
+    if (son_task && !son_task->done_) {
+        son_task->dependent_ = task;
+        task->waiting_sons_++;
+        merge_executor_release(this, son_task);
+    }
+    if (array_list_get_size(&task->sons_) >= task->expected_sons_) {
+        merge_executor_release(this, task);
+    }
+    pthread_mutex_unlock(&this->mutex_);
+}
+
+void merge_executor_wait(merge_executor *this, module *mod) {
+    pthread_mutex_lock(&this->mutex_);
+    merge_task* task = hash_map_get(&this->tasks_, module_get_name(mod));
+    if (task) {
+        merge_executor_release(this, task);
+        while (!task->done_) {
+            pthread_cond_wait(&this->task_done_, &this->mutex_);
+        }
+    }
+    pthread_mutex_unlock(&this->mutex_);
+}
+
+void merge_executor_wait_all(merge_executor *this) {
+    pthread_mutex_lock(&this->mutex_);
+    for (int i = 0; i < array_list_get_size(&this->all_tasks_); i++) {
+        merge_task* task = NULL;
+        array_list_try_get(&this->all_tasks_, i, &task);
+        merge_executor_release(this, task);
+    }
+    for (int i = 0; i < array_list_get_size(&this->all_tasks_); i++) {
+        merge_task* task = NULL;
+        array_list_try_get(&this->all_tasks_, i, &task);
+        while (!task->done_) {
+            pthread_cond_wait(&this->task_done_, &this->mutex_);
+        }
+    }
+    pthread_mutex_unlock(&this->mutex_);
+}
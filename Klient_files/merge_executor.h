@@ -0,0 +1,124 @@
+#ifndef MERGE_EXECUTOR_H
+#define MERGE_EXECUTOR_H
+#include "../Shared/array_list.h"
+#include "../Shared/hash_map.h"
+#include "../Shared/module.h"
+#include <pthread.h>
+
+/**
+ * @brief All merges of sons into one parent, executed in one pass.
+ *
+ * Fields:
+ * - name_: Name of the parent module.
+ * - parent_: Pointer to the parent module, NULL until its first merge arrives.
+ * - sons_: Array list of pointers to the son modules.
+ * - expected_sons_: Number of MERG instructions with this parent.
+ * - waiting_sons_: Number of sons whose own merges did not finish yet.
+ * - dependent_: Task of the parent this module is merged into, or NULL.
+ * - complete_: Whether all sons were added.
+ * - done_: Whether the merge finished.
+ */
+typedef struct merge_task {
+    char* name_;
+    module* parent_;
+    array_list sons_;
+    int expected_sons_;
+    int waiting_sons_;
+    struct merge_task* dependent_;
+    _Bool complete_;
+    _Bool done_;
+} merge_task;
+
+/**
+ * @brief Runs the merges of a client on a pool of worker threads.
+ *
+ * A parent is merged once all its sons were added and their own merges
+ * finished, so merges of disjoint subtrees run in parallel.
+ *
+ * Fields:
+ * - tasks_: Hash map from module names to their merge_task.
+ * - all_tasks_: Array list of all merge_task pointers.
+ * - ready_: Array list of merge_task pointers ready to run.
+ * - threads_: Worker threads.
+ * - thread_count_: Number of worker threads.
+ * - mutex_: Mutex guarding the tasks.
+ * - task_ready_: Signaled when a task is added to ready_ or the workers should stop.
+ * - task_done_: Signaled when a task finishes.
+ * - stopping_: Whether the workers should stop.
+ * - merge_mode_: Way of merging son functions, see module_merge_sons.
+ * - simplify_: Whether merged functions are simplified.
+ */
+typedef struct merge_executor {
+    hash_map tasks_;
+    array_list all_tasks_;
+    array_list ready_;
+    pthread_t* threads_;
+    int thread_count_;
+    pthread_mutex_t mutex_;
+    pthread_cond_t task_ready_;
+    pthread_cond_t task_done_;
+    _Bool stopping_;
+    module_merge_mode merge_mode_;
+    _Bool simplify_;
+} merge_executor;
+
+/**
+ * @brief Initializes a merge executor and starts its worker threads.
+ * @param this Pointer to the merge executor.
+ * @param thread_count Number of worker threads.
+ * @param merge_mode Way of merging son functions.
+ * @param simplify Whether merged functions are simplified.
+ */
+void merge_executor_init(merge_executor* this, int thread_count, module_merge_mode merge_mode, _Bool simplify);
+
+/**
+ * @brief Stops the worker threads and destroys the merge executor.
+ *
+ * All merges must be finished, see merge_executor_wait_all.
+ * @param this Pointer to the merge executor.
+ */
+void merge_executor_destroy(merge_executor* this);
+
+/**
+ * @brief Forgets all merges so the worker threads can run another script.
+ *
+ * All merges must be finished, see merge_executor_wait_all.
+ * @param this Pointer to the merge executor.
+ * @param merge_mode Way of merging son functions.
+ * @param simplify Whether merged functions are simplified.
+ */
+void merge_executor_reset(merge_executor* this, module_merge_mode merge_mode, _Bool simplify);
+
+/**
+ * @brief Counts the MERG instructions of every parent.
+ *
+ * A parent is merged as soon as its last son is added.
+ * @param this Pointer to the merge executor.
+ * @param instructions String containing the client's instructions.
+ */
+void merge_executor_plan(merge_executor* this, const char* instructions);
+
+/**
+ * @brief Adds a merge of a son into its parent.
+ * @param this Pointer to the merge executor.
+ * @param parent Pointer to the parent module.
+ * @param son Pointer to the son module.
+ */
+void merge_executor_add_merge(merge_executor* this, module* parent, module* son);
+
+/**
+ * @brief Waits until all merges into a module finish.
+ *
+ * A module with sons still missing from the plan is merged with the sons it has.
+ * @param this Pointer to the merge executor.
+ * @param mod Pointer to the module.
+ */
+void merge_executor_wait(merge_executor* this, module* mod);
+
+/**
+ * @brief Waits until all merges finish.
+ * @param this Pointer to the merge executor.
+ */
+void merge_executor_wait_all(merge_executor* this);
+
+#endif //MERGE_EXECUTOR_H
@@ -6,6 +6,9 @@
 #include <unistd.h>
 #include <string.h>
 #include <pthread.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
 #include <asm-generic/errno.h>
 
 #include "../Shared/module.h"
@@ -15,12 +18,14 @@ void thread_args_init(thread_args *this, bdd_server *server, pthread_mutex_t *mu
     this->server_ = server;
     this->mutex_ = mutex;
     this->client_id_ = client_id;
+    this->scheduler_ = NULL;
 }
 
 void thread_args_destroy(thread_args *this) {
     this->mutex_ = NULL;
     this->server_ = NULL;
     this->client_id_ = 0;
+    this->scheduler_ = NULL;
 }
 
 bdd_server * thread_args_get_server(thread_args* this) {
@@ -35,13 +40,22 @@ int thread_args_get_client_id(thread_args *this) {
     return this->client_id_;
 }
 
+task_scheduler * thread_args_get_scheduler(thread_args *this) {
+    return this->scheduler_;
+}
+
 void bdd_server_init(bdd_server* this) {
     array_list_init(&this->client_sockets_, sizeof(int));
+    this->compressed_receivers_ = NULL;
+    this->transfer_raw_bytes_ = 0;
+    this->transfer_sent_bytes_ = 0;
 }
 
 void bdd_server_destroy(bdd_server* this) {
     bdd_server_end_sessions(this);
     array_list_destroy(&this->client_sockets_);
+    free(this->compressed_receivers_);
+    this->compressed_receivers_ = NULL;
     close(this->server_id_);
 }
 
@@ -164,34 +178,102 @@ void bdd_server_receive_message(bdd_server *this, int sender_id, bdd_message* me
     recv_all(client_fd, bdd_message_get_buffer(message), *bdd_message_get_buffer_size(message));
 }
 
-void bdd_server_forward_message(bdd_server *this, int client_id, bdd_message* forwarded_message, pthread_mutex_t *mutex) {
-    bdd_server_receive_message(this, client_id, forwarded_message, mutex);
-    bdd_message_deserialize(forwarded_message, NULL);
-    if (bdd_message_get_client_id(forwarded_message) < 0) {
+static _Bool bdd_server_compresses_for(bdd_server *this, int client_id) {
+    return this->compressed_receivers_ && this->compressed_receivers_[0] == '1' &&
+           client_id >= 0 && client_id + 1 < (int)strlen(this->compressed_receivers_) &&
+           this->compressed_receivers_[client_id + 1] == '1';
+}
+
+static void bdd_server_count_transfer(bdd_server *this, size_t raw_size, size_t sent_size, pthread_mutex_t *mutex) {
+    if (mutex) { pthread_mutex_lock(mutex); }
+    this->transfer_raw_bytes_ += raw_size;
+    this->transfer_sent_bytes_ += sent_size;
+    if (mutex) { pthread_mutex_unlock(mutex); }
+}
+
+static void bdd_server_send_module(bdd_server *this, int client_id, module *mod, pthread_mutex_t *mutex) {
+    bdd_message message;
+    bdd_message_init(&message, client_id);
+    bdd_message_set_payload(&message, &mod, sizeof(module*));
+    size_t raw_size = bdd_message_serialize_direct(&message, module_write);
+    if (bdd_server_compresses_for(this, client_id)) {
+        bdd_message_compress(&message);
+    }
+    bdd_server_count_transfer(this, raw_size, *bdd_message_get_buffer_size(&message), mutex);
+    bdd_server_send_message(this, client_id, &message, mutex);
+    bdd_message_destroy(&message);
+}
+
+/**
+ * @brief Sends a serialized module received from a client, compressing a copy of it if the receiver agreed.
+ */
+static void bdd_server_forward_module(bdd_server *this, int client_id, bdd_message *message, pthread_mutex_t *mutex) {
+    size_t raw_size = *bdd_message_get_buffer_size(message);
+    if (!bdd_server_compresses_for(this, client_id)) {
+        bdd_server_count_transfer(this, raw_size, raw_size, mutex);
+        bdd_server_send_message(this, client_id, message, mutex);
         return;
     }
-    bdd_server_send_message(this, bdd_message_get_client_id(forwarded_message), forwarded_message, mutex);
-    bdd_message_clear_buffer(forwarded_message);
+    bdd_message copy;
+    bdd_message_init(&copy, 0);
+    bdd_message_assign(&copy, message);
+    bdd_message_compress(&copy);
+    bdd_server_count_transfer(this, raw_size, *bdd_message_get_buffer_size(&copy), mutex);
+    bdd_server_send_message(this, client_id, &copy, mutex);
+    bdd_message_destroy(&copy);
+}
+
+static void bdd_server_send_string(bdd_server *this, int client_id, char *string, pthread_mutex_t *mutex) {
+    bdd_message message;
+    bdd_message_init(&message, -1);
+    bdd_message_set_payload(&message, string, strlen(string) + 1);
+    bdd_message_serialize(&message, serialize_string);
+    bdd_server_send_message(this, client_id, &message, mutex);
+    bdd_message_destroy(&message);
 }
 
-void * bdd_server_forwarding_mode(void* args) {
+void * bdd_server_task_mode(void* args) {
     bdd_server* this = thread_args_get_server((thread_args*)args);
     pthread_mutex_t* mutex = thread_args_get_mutex((thread_args*)args);
     int client_id = thread_args_get_client_id((thread_args*)args);
+    task_scheduler* scheduler = thread_args_get_scheduler((thread_args*)args);
 
-    bdd_message forwarded_message;
-    bdd_message_init(&forwarded_message, 0);
-    while (bdd_message_get_client_id(&forwarded_message) >= 0) {
-        bdd_server_forward_message(this, client_id, &forwarded_message, mutex);
+    bdd_message* final_message = NULL;
+    char* script = NULL;
+    scheduler_task* task;
+    while (!final_message && (task = task_scheduler_next(scheduler, client_id, &script))) {
+        bdd_server_send_string(this, client_id, script, mutex);
+        free(script);
+
+        bdd_server_send_module(this, client_id, task->module_, mutex);
+        for (int i = 0; i < task->leaf_count_; i++) {
+            bdd_server_send_module(this, client_id, task->leaves_[i], mutex);
+        }
+        for (int i = 0; i < task->son_count_; i++) {
+            if (task->sons_[i]->holder_ < 0) {
+                bdd_server_forward_module(this, client_id, &task->sons_[i]->result_, mutex);
+            }
+        }
+
+        bdd_message reply;
+        bdd_message_init(&reply, 0);
+        bdd_server_receive_message(this, client_id, &reply, mutex);
+        bdd_message_deserialize(&reply, NULL);
+        free(bdd_message_get_unique_payload(&reply));
+        if (bdd_message_get_client_id(&reply) == -2) {
+            final_message = malloc(sizeof(bdd_message));
+            bdd_message_init(final_message, 0);
+            bdd_message_assign(final_message, &reply);
+            task_scheduler_complete(scheduler, task, NULL);
+        } else {
+            task_scheduler_complete(scheduler, task, bdd_message_get_client_id(&reply) == BDD_MESSAGE_TASK_UPLOAD ? &reply : NULL);
+        }
+        bdd_message_destroy(&reply);
     }
 
-    bdd_message* final_message = NULL;
-    if (bdd_message_get_client_id(&forwarded_message) == -2) {
-        final_message = malloc(sizeof(bdd_message));
-        bdd_message_init(final_message, 0);
-        bdd_message_assign(final_message, &forwarded_message);
+    if (!final_message) {
+        bdd_server_send_string(this, client_id, "Client closing", mutex);
     }
-    bdd_message_destroy(&forwarded_message);
     return final_message;
 }
 
@@ -211,15 +293,9 @@ void bdd_server_send_modules(bdd_server *this, array_list *modules, int* distrib
     }
 
     module* temp = NULL;
-    int client_id = 0;
     for (int i = 0; i < array_list_get_size(modules); i++) {
         array_list_try_get(modules, i, &temp);
-        client_id = module_get_assigned_client(temp);
-        bdd_message_init(&message, client_id);
-        bdd_message_set_payload(&message, &temp, sizeof(module*));
-        bdd_message_serialize(&message, module_serialize);
-        bdd_server_send_message(this, client_id, &message, NULL);
-        bdd_message_destroy(&message);
+        bdd_server_send_module(this, module_get_assigned_client(temp), temp, NULL);
     }
 }
 
@@ -253,7 +329,7 @@ _Bool bdd_server_send_instructions(bdd_server *this, char **instructions) {
     return true;
 }
 
-void bdd_server_execute_instructions(bdd_server *this, bdd_message *result) {
+static void bdd_server_run_threads(bdd_server *this, void* (*mode)(void*), task_scheduler *scheduler, bdd_message *result) {
     pthread_mutex_t mutex;
     pthread_mutex_init(&mutex, NULL);
     thread_args* args = malloc(bdd_server_get_client_count(this) * sizeof(thread_args));
@@ -265,9 +341,10 @@ void bdd_server_execute_instructions(bdd_server *this, bdd_message *result) {
         array_list_try_get(&this->client_sockets_, i, &client_fd);
         if (client_fd >= 0) {
             thread_args_init(args + i, this, &mutex, i);
+            args[i].scheduler_ = scheduler;
             pthread_t* thread= malloc(sizeof(pthread_t));
             array_list_add(&threads, &thread);
-            pthread_create(thread, NULL, bdd_server_forwarding_mode, args + i);
+            pthread_create(thread, NULL, mode, args + i);
         }
     }
 
@@ -296,6 +373,485 @@ void bdd_server_execute_instructions(bdd_server *this, bdd_message *result) {
     pthread_mutex_destroy(&mutex);
 }
 
+void bdd_server_negotiate_compression(bdd_server *this, _Bool compress) {
+    int client_count = bdd_server_get_client_count(this);
+    free(this->compressed_receivers_);
+    this->compressed_receivers_ = malloc(client_count + 2);
+    this->compressed_receivers_[0] = compress ? '1' : '0';
+    this->transfer_raw_bytes_ = 0;
+    this->transfer_sent_bytes_ = 0;
+
+    bdd_message message;
+    for (int i = 0; i < client_count; i++) {
+        int client_fd;
+        array_list_try_get(&this->client_sockets_, i, &client_fd);
+        this->compressed_receivers_[i + 1] = '0';
+        if (client_fd < 0) {
+            continue;
+        }
+        bdd_message_init(&message, -1);
+        bdd_server_receive_message(this, i, &message, NULL);
+        bdd_message_deserialize(&message, deserialize_int);
+        if (bdd_message_get_payload(&message) && *(int*)bdd_message_get_payload(&message)) {
+            this->compressed_receivers_[i + 1] = '1';
+        }
+        bdd_message_destroy(&message);
+    }
+    this->compressed_receivers_[client_count + 1] = '\0';
+
+    for (int i = 0; i < client_count; i++) {
+        int client_fd;
+        array_list_try_get(&this->client_sockets_, i, &client_fd);
+        if (client_fd >= 0) {
+            bdd_server_send_string(this, i, this->compressed_receivers_, NULL);
+        }
+    }
+}
+
+void bdd_server_send_merge_mode(bdd_server *this, module_merge_mode merge_mode) {
+    int mode = merge_mode;
+    for (int i = 0; i < bdd_server_get_client_count(this); i++) {
+        int client_fd;
+        array_list_try_get(&this->client_sockets_, i, &client_fd);
+        if (client_fd < 0) {
+            continue;
+        }
+        bdd_message message;
+        bdd_message_init(&message, -1);
+        bdd_message_set_payload(&message, &mode, sizeof(int));
+        bdd_message_serialize(&message, serialize_int);
+        bdd_server_send_message(this, i, &message, NULL);
+        bdd_message_destroy(&message);
+    }
+}
+
+void bdd_server_print_compression(bdd_server *this) {
+    if (!this->compressed_receivers_ || this->compressed_receivers_[0] != '1' || this->transfer_sent_bytes_ == 0) {
+        return;
+    }
+    printf("Odoslané moduly: %zu B, po kompresii %zu B (kompresný pomer %.2f).\n",
+           this->transfer_raw_bytes_, this->transfer_sent_bytes_,
+           (double)this->transfer_raw_bytes_ / (double)this->transfer_sent_bytes_);
+}
+
+void bdd_server_exchange_peers(bdd_server *this, _Bool direct) {
+    int client_count = bdd_server_get_client_count(this);
+    int* ports = calloc(client_count > 0 ? client_count : 1, sizeof(int));
+    bdd_message message;
+    for (int i = 0; i < client_count; i++) {
+        int client_fd;
+        array_list_try_get(&this->client_sockets_, i, &client_fd);
+        if (client_fd < 0) {
+            continue;
+        }
+        bdd_message_init(&message, -1);
+        bdd_server_receive_message(this, i, &message, NULL);
+        bdd_message_deserialize(&message, deserialize_int);
+        ports[i] = bdd_message_get_payload(&message) ? *(int*)bdd_message_get_payload(&message) : 0;
+        bdd_message_destroy(&message);
+    }
+
+    size_t size = (size_t)client_count * (INET_ADDRSTRLEN + 24) + 1;
+    char* table = malloc(size);
+    size_t length = 0;
+    table[0] = '\0';
+    for (int i = 0; i < client_count && direct; i++) {
+        int client_fd;
+        array_list_try_get(&this->client_sockets_, i, &client_fd);
+        struct sockaddr_in address;
+        socklen_t address_length = sizeof(address);
+        char address_string[INET_ADDRSTRLEN];
+        if (client_fd < 0 || ports[i] <= 0) {
+            continue;
+        }
+        // A listening client missing from the table would wait for its modules forever, so all of them go through the server.
+        if (getpeername(client_fd, (struct sockaddr*)&address, &address_length) == -1 ||
+            !inet_ntop(AF_INET, &address.sin_addr, address_string, sizeof(address_string))) {
+            printf("Adresa klienta %d nie je známa, moduly sa posielajú cez server.\n", i);
+            length = 0;
+            table[0] = '\0';
+            break;
+        }
+        length += snprintf(table + length, size - length, "%d %s %d\n", i, address_string, ports[i]);
+    }
+
+    for (int i = 0; i < client_count; i++) {
+        int client_fd;
+        array_list_try_get(&this->client_sockets_, i, &client_fd);
+        if (client_fd >= 0) {
+            bdd_server_send_string(this, i, table, NULL);
+        }
+    }
+
+    free(table);
+    free(ports);
+}
+
+/**
+ * @brief Part of a message waiting to be written to a client.
+ *
+ * Fields:
+ * - data_: Bytes of the message.
+ * - size_: Number of bytes in data_.
+ * - offset_: Number of bytes of data_ already written.
+ * - next_: Next chunk for the same client, or NULL.
+ */
+typedef struct forward_chunk {
+    char* data_;
+    size_t size_;
+    size_t offset_;
+    struct forward_chunk* next_;
+} forward_chunk;
+
+/**
+ * @brief State of one client connection in the forwarding loop.
+ *
+ * A message for another client is streamed to it in chunks as it arrives,
+ * only messages for the server are read whole.
+ *
+ * Fields:
+ * - fd_: Socket descriptor of the client, or -1.
+ * - client_id_: ID of the client.
+ * - size_: Size of the message being read.
+ * - size_read_: Number of bytes of size_ already read.
+ * - receiver_id_: ID of the client the message is for, read from its first bytes.
+ * - body_read_: Number of bytes of the message already read.
+ * - body_: Buffer of a message for the server, or NULL.
+ * - receiver_: Connection the message is streamed to, or NULL.
+ * - streaming_from_: Connection streaming a message to this one, or NULL.
+ * - out_head_: First chunk waiting to be written, or NULL.
+ * - out_tail_: Last chunk waiting to be written, or NULL.
+ * - queued_: Number of bytes of the chunks waiting to be written.
+ * - reading_: Whether the client did not finish or disconnect yet.
+ * - waiting_: Whether reading waits until the receiver finishes another stream or writes its backlog.
+ * - events_: Events the socket is registered for in the epoll instance, 0 when it is not registered.
+ */
+typedef struct forward_connection {
+    int fd_;
+    int client_id_;
+    size_t size_;
+    size_t size_read_;
+    int receiver_id_;
+    size_t body_read_;
+    char* body_;
+    struct forward_connection* receiver_;
+    struct forward_connection* streaming_from_;
+    forward_chunk* out_head_;
+    forward_chunk* out_tail_;
+    size_t queued_;
+    _Bool reading_;
+    _Bool waiting_;
+    uint32_t events_;
+} forward_connection;
+
+/**
+ * @brief Registers the socket for the events the connection waits for.
+ *
+ * A socket with nothing to wait for is removed from the epoll instance,
+ * otherwise a hang up, which is always reported, would wake the loop forever.
+ */
+static void forward_connection_update(forward_connection* this, int epoll_fd) {
+    struct epoll_event event;
+    event.events = (this->reading_ && !this->waiting_ ? EPOLLIN : 0) | (this->out_head_ ? EPOLLOUT : 0);
+    event.data.ptr = this;
+    if (event.events == this->events_) {
+        return;
+    }
+    if (event.events == 0) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, this->fd_, NULL);
+    } else {
+        epoll_ctl(epoll_fd, this->events_ == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, this->fd_, &event);
+    }
+    this->events_ = event.events;
+}
+
+static void forward_connection_enqueue(forward_connection* this, char* data, size_t size) {
+    forward_chunk* chunk = malloc(sizeof(forward_chunk));
+    chunk->data_ = data;
+    chunk->size_ = size;
+    chunk->offset_ = 0;
+    chunk->next_ = NULL;
+    if (this->out_tail_) {
+        this->out_tail_->next_ = chunk;
+    } else {
+        this->out_head_ = chunk;
+    }
+    this->out_tail_ = chunk;
+    this->queued_ += size;
+}
+
+static void forward_connection_pop(forward_connection* this) {
+    forward_chunk* chunk = this->out_head_;
+    this->out_head_ = chunk->next_;
+    if (!this->out_head_) {
+        this->out_tail_ = NULL;
+    }
+    this->queued_ -= chunk->size_;
+    free(chunk->data_);
+    free(chunk);
+}
+
+static void forward_connection_flush(forward_connection* this) {
+    while (this->out_head_) {
+        struct iovec parts[BDD_SERVER_RELAY_IOV];
+        int part_count = 0;
+        for (forward_chunk* chunk = this->out_head_; chunk && part_count < BDD_SERVER_RELAY_IOV; chunk = chunk->next_) {
+            parts[part_count].iov_base = chunk->data_ + chunk->offset_;
+            parts[part_count].iov_len = chunk->size_ - chunk->offset_;
+            part_count++;
+        }
+
+        ssize_t written = writev(this->fd_, parts, part_count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            printf("Klient %d sa odpojil, správy pre neho sa zahadzujú.\n", this->client_id_);
+            while (this->out_head_) {
+                forward_connection_pop(this);
+            }
+            return;
+        }
+
+        while (written > 0) {
+            forward_chunk* chunk = this->out_head_;
+            size_t part = chunk->size_ - chunk->offset_ < (size_t)written ? chunk->size_ - chunk->offset_ : (size_t)written;
+            chunk->offset_ += part;
+            written -= part;
+            if (chunk->offset_ == chunk->size_) {
+                forward_connection_pop(this);
+            }
+        }
+    }
+}
+
+static void forward_connection_reset(forward_connection* this) {
+    this->size_read_ = 0;
+    this->body_read_ = 0;
+    this->receiver_id_ = -1;
+    this->body_ = NULL;
+    this->receiver_ = NULL;
+}
+
+/**
+ * @brief Lets the connections waiting for a receiver read again once its stream ended.
+ */
+static void forward_connection_release(forward_connection* this, forward_connection* connections, int client_count, int epoll_fd) {
+    this->streaming_from_ = NULL;
+    for (int i = 0; i < client_count; i++) {
+        if (connections[i].waiting_ && connections[i].receiver_ == this) {
+            connections[i].waiting_ = false;
+            forward_connection_update(connections + i, epoll_fd);
+        }
+    }
+}
+
+/**
+ * @brief Lets the connection streaming to this one read again once the backlog is written.
+ */
+static void forward_connection_resume(forward_connection* this, int epoll_fd) {
+    forward_connection* sender = this->streaming_from_;
+    if (sender && sender->waiting_ && this->queued_ < BDD_SERVER_RELAY_BACKLOG) {
+        sender->waiting_ = false;
+        forward_connection_update(sender, epoll_fd);
+    }
+}
+
+static void forward_connection_stop_reading(forward_connection* this, forward_connection* connections, int client_count, int epoll_fd) {
+    if (this->receiver_ && this->receiver_->streaming_from_ == this) {
+        forward_connection_release(this->receiver_, connections, client_count, epoll_fd);
+    }
+    free(this->body_);
+    forward_connection_reset(this);
+    this->reading_ = false;
+    this->waiting_ = false;
+}
+
+/**
+ * @brief Reads from a client until its socket would block.
+ * @return Whether the client is still reading.
+ */
+static _Bool forward_connection_read(forward_connection* this, forward_connection* connections, int client_count, int epoll_fd, bdd_message* result) {
+    while (this->reading_ && !this->waiting_) {
+        ssize_t received;
+        size_t id_size = this->size_ < sizeof(this->receiver_id_) ? this->size_ : sizeof(this->receiver_id_);
+        char* chunk = NULL;
+
+        if (this->size_read_ < sizeof(this->size_)) {
+            received = recv(this->fd_, (char*)&this->size_ + this->size_read_, sizeof(this->size_) - this->size_read_, 0);
+            if (received > 0) {
+                this->size_read_ += received;
+            }
+        } else if (this->body_read_ < id_size) {
+            // The serialized message starts with the ID of the receiving client, see bdd_message_serialize.
+            received = recv(this->fd_, (char*)&this->receiver_id_ + this->body_read_, id_size - this->body_read_, 0);
+            if (received > 0) {
+                this->body_read_ += received;
+            }
+        } else if (this->receiver_id_ < 0) {
+            if (!this->body_) {
+                this->body_ = malloc(this->size_ > 0 ? this->size_ : 1);
+                memcpy(this->body_, &this->receiver_id_, this->body_read_);
+            }
+            received = this->body_read_ < this->size_ ? recv(this->fd_, this->body_ + this->body_read_, this->size_ - this->body_read_, 0) : 0;
+            if (received > 0) {
+                this->body_read_ += received;
+            }
+            if (this->body_read_ == this->size_) {
+                if (this->receiver_id_ == -2) {
+                    bdd_message_clear_buffer(result);
+                    result->serialized_buffer_ = this->body_;
+                    result->serialized_buffer_size_ = this->size_;
+                    this->body_ = NULL;
+                }
+                forward_connection_stop_reading(this, connections, client_count, epoll_fd);
+                return false;
+            }
+        } else {
+            if (!this->receiver_ && this->receiver_id_ < client_count && connections[this->receiver_id_].fd_ >= 0) {
+                this->receiver_ = connections + this->receiver_id_;
+            }
+            forward_connection* receiver = this->receiver_;
+            if (receiver && receiver->streaming_from_ != this) {
+                if (receiver->streaming_from_) {
+                    this->waiting_ = true;
+                    break;
+                }
+                receiver->streaming_from_ = this;
+                char* header = malloc(sizeof(this->size_) + this->body_read_);
+                memcpy(header, &this->size_, sizeof(this->size_));
+                memcpy(header + sizeof(this->size_), &this->receiver_id_, this->body_read_);
+                forward_connection_enqueue(receiver, header, sizeof(this->size_) + this->body_read_);
+            }
+
+            // A receiver that waits itself may be a client blocked sending, so its backlog is left to grow to avoid a cycle of waits.
+            if (receiver && receiver->queued_ >= BDD_SERVER_RELAY_BACKLOG && !receiver->waiting_) {
+                forward_connection_update(receiver, epoll_fd);
+                this->waiting_ = true;
+                break;
+            }
+            if (this->body_read_ < this->size_) {
+                size_t remaining = this->size_ - this->body_read_;
+                size_t chunk_size = remaining < BDD_SERVER_RELAY_CHUNK ? remaining : BDD_SERVER_RELAY_CHUNK;
+                chunk = malloc(chunk_size);
+                received = recv(this->fd_, chunk, chunk_size, 0);
+                if (received > 0) {
+                    this->body_read_ += received;
+                    if (receiver) {
+                        forward_connection_enqueue(receiver, chunk, received);
+                        chunk = NULL;
+                    }
+                }
+                free(chunk);
+            } else {
+                received = 0;
+            }
+
+            if (receiver) {
+                forward_connection_flush(receiver);
+                forward_connection_update(receiver, epoll_fd);
+            }
+            if (this->body_read_ == this->size_) {
+                if (receiver) {
+                    forward_connection_release(receiver, connections, client_count, epoll_fd);
+                } else {
+                    printf("Klient %d sa nepoužíva.\n", this->receiver_id_);
+                }
+                forward_connection_reset(this);
+                continue;
+            }
+        }
+
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (received <= 0) {
+            printf("Klient %d sa odpojil.\n", this->client_id_);
+            forward_connection_stop_reading(this, connections, client_count, epoll_fd);
+            return false;
+        }
+    }
+    return this->reading_;
+}
+
+void bdd_server_execute_instructions(bdd_server *this, bdd_message *result) {
+    int client_count = bdd_server_get_client_count(this);
+    forward_connection* connections = calloc(client_count > 0 ? client_count : 1, sizeof(forward_connection));
+    int epoll_fd = epoll_create1(0);
+    int open_connections = 0;
+
+    for (int i = 0; i < client_count; i++) {
+        forward_connection* connection = connections + i;
+        array_list_try_get(&this->client_sockets_, i, &connection->fd_);
+        connection->client_id_ = i;
+        forward_connection_reset(connection);
+        if (connection->fd_ < 0) {
+            continue;
+        }
+        fcntl(connection->fd_, F_SETFL, fcntl(connection->fd_, F_GETFL) | O_NONBLOCK);
+        connection->reading_ = true;
+        forward_connection_update(connection, epoll_fd);
+        open_connections++;
+    }
+
+    struct epoll_event events[BDD_SERVER_EPOLL_EVENTS];
+    while (true) {
+        _Bool pending = open_connections > 0;
+        for (int i = 0; i < client_count && !pending; i++) {
+            pending = connections[i].out_head_ != NULL;
+        }
+        if (!pending) {
+            break;
+        }
+
+        int event_count = epoll_wait(epoll_fd, events, BDD_SERVER_EPOLL_EVENTS, -1);
+        if (event_count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Chyba pri čakaní na klientov");
+            break;
+        }
+
+        for (int i = 0; i < event_count; i++) {
+            forward_connection* connection = events[i].data.ptr;
+            if (events[i].events & EPOLLOUT) {
+                forward_connection_flush(connection);
+                forward_connection_resume(connection, epoll_fd);
+            }
+            if (connection->reading_ && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) &&
+                !forward_connection_read(connection, connections, client_count, epoll_fd, result)) {
+                open_connections--;
+            }
+            forward_connection_update(connection, epoll_fd);
+        }
+    }
+
+    for (int i = 0; i < client_count; i++) {
+        forward_connection* connection = connections + i;
+        if (connection->fd_ < 0) {
+            continue;
+        }
+        while (connection->out_head_) {
+            forward_connection_pop(connection);
+        }
+        free(connection->body_);
+        fcntl(connection->fd_, F_SETFL, fcntl(connection->fd_, F_GETFL) & ~O_NONBLOCK);
+    }
+    close(epoll_fd);
+    free(connections);
+}
+
+void bdd_server_execute_tasks(bdd_server *this, task_scheduler *scheduler, bdd_message *result) {
+    bdd_server_run_threads(this, bdd_server_task_mode, scheduler, result);
+}
+
 bool is_client_connected(int client_fd)
 {
     char buf;
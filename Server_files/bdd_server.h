@@ -3,8 +3,32 @@
 #include <arpa/inet.h>
 #include "../Shared/array_list.h"
 #include "../Shared/bdd_message.h"
+#include "task_scheduler.h"
 
-#define MAX_CLIENTS 10
+/**
+ * @brief Maximum number of connected clients.
+ */
+#define MAX_CLIENTS 1024
+
+/**
+ * @brief Maximum number of socket events handled per wakeup of the forwarding loop.
+ */
+#define BDD_SERVER_EPOLL_EVENTS 64
+
+/**
+ * @brief Maximum number of bytes read at once from a message relayed to another client.
+ */
+#define BDD_SERVER_RELAY_CHUNK (64 * 1024)
+
+/**
+ * @brief Maximum number of chunks written to a client in one call.
+ */
+#define BDD_SERVER_RELAY_IOV 16
+
+/**
+ * @brief Number of bytes queued for a client after which the server stops reading the message relayed to it.
+ */
+#define BDD_SERVER_RELAY_BACKLOG (16 * BDD_SERVER_RELAY_CHUNK)
 
 /**
  * @brief Represents a server for managing client connections.
@@ -13,11 +37,18 @@
  * - client_sockets_: List of client socket descriptors.
  * - server_id_: Server's socket descriptor.
  * - server_addr_: Server's address and port information.
+ * - compressed_receivers_: Acceptance of compressed modules, '1' at index 0 for the server and at
+ *   index i + 1 for client i, or NULL before bdd_server_negotiate_compression.
+ * - transfer_raw_bytes_: Size of the modules sent in this run before compression.
+ * - transfer_sent_bytes_: Size of the modules sent in this run as sent.
  */
 typedef struct bdd_server {
     array_list client_sockets_;
     int server_id_;
     struct sockaddr_in server_addr_;
+    char* compressed_receivers_;
+    size_t transfer_raw_bytes_;
+    size_t transfer_sent_bytes_;
 } bdd_server;
 
 /**
@@ -27,11 +58,13 @@ typedef struct bdd_server {
  * - server_: Pointer to the server instance.
  * - mutex_: Pointer to a mutex for synchronizing threads.
  * - client_id_: ID of the client associated with the thread.
+ * - scheduler_: Task scheduler handing out tasks to the client, or NULL.
  */
 typedef struct thread_args {
     bdd_server* server_;
     pthread_mutex_t* mutex_;
     int client_id_;
+    task_scheduler* scheduler_;
 } thread_args;
 
 /**
@@ -70,6 +103,13 @@ pthread_mutex_t* thread_args_get_mutex(thread_args *this);
  */
 int thread_args_get_client_id(thread_args *this);
 
+/**
+ * @brief Retrieves the task scheduler from thread_args.
+ * @param this Pointer to the thread_args structure.
+ * @return Pointer to the task scheduler, or NULL.
+ */
+task_scheduler* thread_args_get_scheduler(thread_args *this);
+
 /**
  * @brief Initializes a bdd_server instance.
  * @param this Pointer to the server instance.
@@ -137,20 +177,14 @@ void bdd_server_send_message(bdd_server* this, int receiver_id, bdd_message* mes
 void bdd_server_receive_message(bdd_server *this, int sender_id, bdd_message* message, pthread_mutex_t *mutex);
 
 /**
- * @brief Forwards a message from one client to another.
- * @param this Pointer to the server instance.
- * @param client_id ID of the sending client.
- * @param forwarded_message Pointer to the message to forward.
- * @param mutex Optional mutex for synchronization.
- */
-void bdd_server_forward_message(bdd_server *this, int client_id, bdd_message* forwarded_message, pthread_mutex_t *mutex);
-
-/**
- * @brief Thread function for handling message forwarding.
+ * @brief Thread function handing out tasks to a client until the root is done.
+ *
+ * Every task script is followed by the modules it receives, see
+ * task_scheduler_next.
  * @param args Pointer to thread arguments.
- * @return Pointer to a result message (or NULL).
+ * @return Pointer to the result message if the client ran the root task (or NULL).
  */
-void* bdd_server_forwarding_mode(void* args);
+void* bdd_server_task_mode(void* args);
 
 /**
  * @brief Sends modules to clients based on their distribution.
@@ -169,13 +203,68 @@ void bdd_server_send_modules(bdd_server *this, array_list *modules, int* distrib
  */
 _Bool bdd_server_send_instructions(bdd_server *this, char **instructions);
 
+/**
+ * @brief Exchanges the addresses clients receive modules from other clients on.
+ *
+ * Every client still connected after the instructions sends the port it
+ * listens on, or 0, and receives a table of "client_id address port" lines
+ * of the other clients. The table is empty when modules are relayed through
+ * the server instead, also when the address of a listening client is unknown.
+ * @param this Pointer to the server instance.
+ * @param direct Whether clients send modules to each other directly.
+ */
+void bdd_server_exchange_peers(bdd_server *this, _Bool direct);
+
+/**
+ * @brief Agrees with the clients on which connections carry compressed modules.
+ *
+ * Every client still connected after the instructions sends whether it
+ * accepts compressed modules and receives the acceptance of the server and
+ * of all clients. A module is compressed only if both its sender and its
+ * receiver accept it.
+ * @param this Pointer to the server instance.
+ * @param compress Whether the server sends and accepts compressed modules.
+ */
+void bdd_server_negotiate_compression(bdd_server *this, _Bool compress);
+
+/**
+ * @brief Sends every client still connected the way it merges son functions in this run.
+ *
+ * All clients merge the same way, a parent merged on one client relies on
+ * its sons holding the cubes the mode produces on the others.
+ * @param this Pointer to the server instance.
+ * @param merge_mode Way of merging son functions, see module_merge_sons.
+ */
+void bdd_server_send_merge_mode(bdd_server *this, module_merge_mode merge_mode);
+
+/**
+ * @brief Prints how much the compression reduced the modules sent in this run.
+ * @param this Pointer to the server instance.
+ */
+void bdd_server_print_compression(bdd_server *this);
+
 /**
  * @brief Executes instructions by forwarding messages between clients.
+ *
+ * All client sockets are multiplexed with epoll on the calling thread.
+ * A message for another client is streamed to it chunk by chunk as it
+ * arrives, a receiver takes one stream at a time. A client is done after
+ * sending its finish signal or the result.
  * @param this Pointer to the server instance.
  * @param result Pointer to store the result message.
  */
 void bdd_server_execute_instructions(bdd_server *this, bdd_message *result);
 
+/**
+ * @brief Hands out merge tasks to clients on demand until the root is done.
+ *
+ * Clients must have received "DYNM" as their instructions.
+ * @param this Pointer to the server instance.
+ * @param scheduler Pointer to the task scheduler.
+ * @param result Pointer to store the result message.
+ */
+void bdd_server_execute_tasks(bdd_server *this, task_scheduler *scheduler, bdd_message *result);
+
 /**
  * @brief Finds out whether is client with that fd still connected.
  *
@@ -1,5 +1,6 @@
 #include "module_manager.h"
 #include <ctype.h>
+#include <unistd.h>
 
 void module_manager_init(module_manager *this, int client_count) {
     this->client_count_ = client_count;
@@ -9,6 +10,7 @@ void module_manager_init(module_manager *this, int client_count) {
         this->instructions_[i][0] = 'X';
     }
     array_list_init(&this->modules_, sizeof(module*));
+    hash_map_init(&this->module_index_);
 }
 
 void module_manager_free_module(const void * item) {
@@ -23,9 +25,14 @@ void module_manager_destroy(module_manager *this) {
     free(this->instructions_);
     array_list_process_all(&this->modules_, module_manager_free_module);
     array_list_destroy(&this->modules_);
+    hash_map_destroy(&this->module_index_);
     this->client_count_ = 0;
 }
 
+module* module_manager_get_module(module_manager *this, char *module_name) {
+    return hash_map_get(&this->module_index_, module_name);
+}
+
 array_list* module_manager_get_modules(module_manager *this) {
     return &this->modules_;
 }
@@ -59,8 +66,8 @@ void module_manager_load_modules(module_manager *this, const char *conf_file_pat
             break;
         }
 
-        char module_name[16];
-        char module_path[256];
+        char module_name[sizeof(line)];
+        char module_path[sizeof(line)];
         int pla_index = strstr(line, ".pla") - line + 4;
 
         if (pla_index < 0 || pla_index >= sizeof(line)) {
@@ -72,11 +79,23 @@ void module_manager_load_modules(module_manager *this, const char *conf_file_pat
         strncpy(module_path, line + strlen(module_name) + 1, pla_index - strlen(module_name) - 1);
         module_path[pla_index - strlen(module_name) - 1] = '\0';
 
+        // The output column may be followed, or replaced, by the mv flag of a multi-valued module.
+        int output_column = 0;
+        char flag[8] = "";
+        if (sscanf(line + pla_index, "%d %7s", &output_column, flag) < 1) {
+            sscanf(line + pla_index, "%7s", flag);
+        }
+
         module *mod = malloc(sizeof(module));
         module_init(mod, module_name);
         module_set_path(mod, module_path);
+        module_set_output_column(mod, output_column);
+        if (strcmp(flag, "mv") == 0) {
+            module_set_multi_valued(mod);
+        }
 
         array_list_add(&this->modules_, &mod);
+        hash_map_put(&this->module_index_, module_get_name(mod), mod);
     }
 
     do {
@@ -84,17 +103,16 @@ void module_manager_load_modules(module_manager *this, const char *conf_file_pat
             continue;
         }
 
-        char module_name[16];
-        char mapping[256];
+        char module_name[sizeof(line)];
+        char mapping[sizeof(line)];
         sscanf(line, "%s %s", module_name, mapping);
 
-        module *mod = NULL;
-        array_list_find_by_property(&this->modules_, &mod, module_match_name, module_name);
+        module *mod = module_manager_get_module(this, module_name);
 
         int digits = 0;
         for (int i = 0; i < strlen(mapping); i++) {
             if (mapping[i] == 'M') {
-                char son_name[16];
+                char son_name[sizeof(line)];
                 int son_position = i - digits;
                 int j = i;
 
@@ -108,8 +126,7 @@ void module_manager_load_modules(module_manager *this, const char *conf_file_pat
                 son_name[j - i] = '\0';
                 i = j - 1;
 
-                module *son_mod = NULL;
-                array_list_find_by_property(&this->modules_, &son_mod, module_match_name, son_name);
+                module *son_mod = module_manager_get_module(this, son_name);
                 module_add_son(mod, son_mod, son_position);
             }
         }
@@ -120,7 +137,50 @@ void module_manager_load_modules(module_manager *this, const char *conf_file_pat
 }
 
 void module_manager_load_plas(module_manager *this) {
-    array_list_process_all(&this->modules_, module_load_pla);
+    pla_cache cache;
+    pla_cache_init(&cache);
+
+    for (int i = 0; i < array_list_get_size(&this->modules_); i++) {
+        module* mod = NULL;
+        array_list_try_get(&this->modules_, i, &mod);
+        if (module_get_path(mod) && !module_get_mv_function(mod)) {
+            pla_cache_add_path(&cache, module_get_path(mod));
+        }
+    }
+
+    long thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    pla_cache_load(&cache, thread_count > 0 ? (int)thread_count : 1);
+
+    for (int i = 0; i < array_list_get_size(&this->modules_); i++) {
+        module* mod = NULL;
+        array_list_try_get(&this->modules_, i, &mod);
+        char* path = module_get_path(mod);
+
+        if (!path) {
+            fprintf(stderr, "Module path is not set. Cannot load PLA file.\n");
+            pla_function_init(module_get_function(mod), 0, 0);
+            continue;
+        }
+
+        if (module_get_mv_function(mod)) {
+            mv_function_destroy(module_get_mv_function(mod));
+            if (!mv_function_load_file(module_get_mv_function(mod), path)) {
+                fprintf(stderr, "Failed to load multi-valued PLA file %s for module %s.\n", path, module_get_name(mod));
+            }
+            pla_function_init(module_get_function(mod), 0, 0);
+            continue;
+        }
+
+        pla_function* cached = pla_cache_get(&cache, path, module_get_output_column(mod));
+        if (!cached) {
+            fprintf(stderr, "Failed to load PLA file %s for module %s.\n", path, module_get_name(mod));
+            pla_function_init(module_get_function(mod), 0, 0);
+            continue;
+        }
+        pla_function_share(module_get_function(mod), cached);
+    }
+
+    pla_cache_destroy(&cache);
 }
 
 void module_manager_add_instruction(module_manager *this, int client_id, char* instruction) {
@@ -1,18 +1,22 @@
 #ifndef MODULE_MANAGER_H
 #define MODULE_MANAGER_H
 #include "../Shared/array_list.h"
+#include "../Shared/hash_map.h"
 #include "../Shared/module.h"
+#include "pla_cache.h"
 
 /**
  * @brief Manages a collection of modules and client instructions.
  *
  * Fields:
  * - modules_: Array list of modules managed by the manager.
+ * - module_index_: Hash map from module names to the modules in modules_.
  * - instructions_: Array of instruction strings for clients.
  * - client_count_: Number of clients.
  */
 typedef struct module_manager {
     array_list modules_;
+    hash_map module_index_;
     char** instructions_;
     int client_count_;
 } module_manager;
@@ -36,6 +40,14 @@ void module_manager_free_module(const void *item);
  */
 void module_manager_destroy(module_manager *this);
 
+/**
+ * @brief Finds a module by its name.
+ * @param this Pointer to the module manager.
+ * @param module_name Name of the module.
+ * @return Pointer to the module, or NULL if not found.
+ */
+module* module_manager_get_module(module_manager *this, char *module_name);
+
 /**
  * @brief Retrieves the array list of modules.
  * @param this Pointer to the module manager.
@@ -59,6 +71,9 @@ void module_manager_load(module_manager *this, const char *conf_file_path);
 
 /**
  * @brief Loads module definitions from a configuration file.
+ *
+ * A module line is "name path [output_column] [mv]", the mv flag marks a
+ * multi-valued module, see module_set_multi_valued.
  * @param this Pointer to the module manager.
  * @param conf_file_path Path to the configuration file.
  */
@@ -66,6 +81,11 @@ void module_manager_load_modules(module_manager *this, const char *conf_file_pat
 
 /**
  * @brief Loads PLA files for all modules managed by the manager.
+ *
+ * Every distinct file is parsed once through a pla_cache, modules with
+ * the same file and output column share one function copy-on-write.
+ * Files are read and parsed on one thread per online processor.
+ * Multi-valued modules are parsed by mv_function_load_file instead.
  * @param this Pointer to the module manager.
  */
 void module_manager_load_plas(module_manager *this);
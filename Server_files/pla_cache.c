@@ -0,0 +1,204 @@
+#include "pla_cache.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void pla_cache_free_path(const void* item) {
+    pla_cache_path* path = *(pla_cache_path**)item;
+    if (path->loaded_ && !path->stored_) {
+        pla_function_destroy(&path->function_);
+    }
+    free(path->path_);
+    free(path);
+}
+
+static void pla_cache_free_entry(const void* item) {
+    pla_cache_entry* entry = *(pla_cache_entry**)item;
+    for (int i = 0; i < pla_function_get_num_outputs(&entry->function_); i++) {
+        if (entry->outputs_[i]) {
+            pla_function_destroy(entry->outputs_[i]);
+            free(entry->outputs_[i]);
+        }
+    }
+    free(entry->outputs_);
+    pla_function_destroy(&entry->function_);
+    free(entry);
+}
+
+static pla_cache_entry* pla_cache_add_entry(pla_cache* this, pla_cache_path* record) {
+    pla_cache_entry* entry = malloc(sizeof(pla_cache_entry));
+    snprintf(entry->key_, sizeof(entry->key_), "%016" PRIx64 ":%zx", record->content_hash_, record->length_);
+    entry->content_hash_ = record->content_hash_;
+    entry->length_ = record->length_;
+    entry->function_ = record->function_;
+    entry->outputs_ = calloc(pla_function_get_num_outputs(&entry->function_), sizeof(pla_function*));
+    entry->next_ = NULL;
+    array_list_add(&this->entries_, &entry);
+    return entry;
+}
+
+static pla_cache_path* pla_cache_find_path(pla_cache* this, const char* path) {
+    return hash_map_get(&this->path_index_, path);
+}
+
+static _Bool pla_cache_read_path(pla_cache_path* record) {
+    size_t length = 0;
+    const char* text = pla_function_map_file(record->path_, &length);
+    if (!text) {
+        return false;
+    }
+
+    record->content_hash_ = pla_cache_hash(text, length);
+    record->length_ = length;
+    _Bool parsed = pla_function_parse(&record->function_, text, length);
+    if (!parsed) {
+        fprintf(stderr, "Failed to parse PLA file %s.\n", record->path_);
+        pla_function_destroy(&record->function_);
+    }
+
+    pla_function_unmap_file(text, length);
+    return parsed;
+}
+
+static void pla_cache_store_path(pla_cache* this, pla_cache_path* record) {
+    record->stored_ = true;
+    if (!record->loaded_) {
+        return;
+    }
+
+    char key[PLA_CACHE_KEY_LENGTH];
+    snprintf(key, sizeof(key), "%016" PRIx64 ":%zx", record->content_hash_, record->length_);
+    pla_cache_entry* entry = hash_map_get(&this->entry_index_, key);
+    pla_cache_entry* last = NULL;
+    // Equal hashes and lengths do not prove equal contents, the parsed functions decide.
+    while (entry && !pla_function_equals(&entry->function_, &record->function_)) {
+        last = entry;
+        entry = entry->next_;
+    }
+    if (entry) {
+        pla_function_destroy(&record->function_);
+        record->entry_ = entry;
+        return;
+    }
+
+    record->entry_ = pla_cache_add_entry(this, record);
+    if (last) {
+        last->next_ = record->entry_;
+    } else {
+        hash_map_put(&this->entry_index_, record->entry_->key_, record->entry_);
+    }
+}
+
+static void* pla_cache_load_thread(void* args) {
+    pla_cache_loader* loader = args;
+    while (true) {
+        pthread_mutex_lock(loader->mutex_);
+        int index = loader->next_path_++;
+        pthread_mutex_unlock(loader->mutex_);
+
+        pla_cache_path* record = NULL;
+        if (!array_list_try_get(&loader->cache_->paths_, index, &record)) {
+            return NULL;
+        }
+        if (!record->read_) {
+            record->loaded_ = pla_cache_read_path(record);
+            record->read_ = true;
+        }
+    }
+}
+
+void pla_cache_init(pla_cache *this) {
+    array_list_init(&this->paths_, sizeof(pla_cache_path*));
+    hash_map_init(&this->path_index_);
+    array_list_init(&this->entries_, sizeof(pla_cache_entry*));
+    hash_map_init(&this->entry_index_);
+}
+
+void pla_cache_destroy(pla_cache *this) {
+    hash_map_destroy(&this->path_index_);
+    hash_map_destroy(&this->entry_index_);
+    array_list_process_all(&this->paths_, pla_cache_free_path);
+    array_list_destroy(&this->paths_);
+    array_list_process_all(&this->entries_, pla_cache_free_entry);
+    array_list_destroy(&this->entries_);
+}
+
+uint64_t pla_cache_hash(const char *text, size_t length) {
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+void pla_cache_add_path(pla_cache *this, const char *path) {
+    if (pla_cache_find_path(this, path)) {
+        return;
+    }
+    pla_cache_path* record = malloc(sizeof(pla_cache_path));
+    record->path_ = strdup(path);
+    record->content_hash_ = 0;
+    record->length_ = 0;
+    record->entry_ = NULL;
+    record->read_ = false;
+    record->stored_ = false;
+    record->loaded_ = false;
+    array_list_add(&this->paths_, &record);
+    hash_map_put(&this->path_index_, record->path_, record);
+}
+
+void pla_cache_load(pla_cache *this, int thread_count) {
+    pthread_mutex_t mutex;
+    pthread_mutex_init(&mutex, NULL);
+    pla_cache_loader loader = { this, &mutex, 0 };
+
+    if (thread_count < 1) {
+        thread_count = 1;
+    }
+    pthread_t* threads = malloc(thread_count * sizeof(pthread_t));
+    int started = 0;
+    // A thread that cannot be created is left out, the calling thread reads the remaining files.
+    while (started < thread_count - 1 && pthread_create(threads + started, NULL, pla_cache_load_thread, &loader) == 0) {
+        started++;
+    }
+    pla_cache_load_thread(&loader);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&mutex);
+
+    for (int i = 0; i < array_list_get_size(&this->paths_); i++) {
+        pla_cache_path* record = NULL;
+        array_list_try_get(&this->paths_, i, &record);
+        if (record->read_ && !record->stored_) {
+            pla_cache_store_path(this, record);
+        }
+    }
+}
+
+pla_function * pla_cache_get(pla_cache *this, const char *path, int output_column) {
+    pla_cache_path* record = pla_cache_find_path(this, path);
+    if (!record || !record->read_) {
+        pla_cache_add_path(this, path);
+        pla_cache_load(this, 1);
+        record = pla_cache_find_path(this, path);
+    }
+    if (!record->loaded_) {
+        return NULL;
+    }
+
+    pla_cache_entry* full = record->entry_;
+    if (output_column < 0 || output_column >= pla_function_get_num_outputs(&full->function_)) {
+        fprintf(stderr, "Output column %d is out of range for PLA file %s.\n", output_column, path);
+        return NULL;
+    }
+
+    if (!full->outputs_[output_column]) {
+        full->outputs_[output_column] = malloc(sizeof(pla_function));
+        pla_function_assign_output(full->outputs_[output_column], &full->function_, output_column);
+    }
+    return full->outputs_[output_column];
+}
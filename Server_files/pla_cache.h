@@ -0,0 +1,141 @@
+#ifndef PLA_CACHE_H
+#define PLA_CACHE_H
+#include "../Shared/array_list.h"
+#include "../Shared/hash_map.h"
+#include "../Shared/pla_function.h"
+#include <pthread.h>
+
+/**
+ * @brief Length of the hash map key of a cache entry, including the terminator.
+ */
+#define PLA_CACHE_KEY_LENGTH 40
+
+/**
+ * @brief Parsed PLA file stored in the cache.
+ *
+ * Fields:
+ * - key_: Hash map key built from content_hash_ and length_.
+ * - content_hash_: Hash of the PLA file contents.
+ * - length_: Length of the PLA file contents.
+ * - function_: Parse of the file with all outputs.
+ * - outputs_: Single-output functions indexed by output column, NULL until extracted.
+ * - next_: Entry with the same hash and length but different contents, NULL if none.
+ */
+typedef struct pla_cache_entry {
+    char key_[PLA_CACHE_KEY_LENGTH];
+    uint64_t content_hash_;
+    size_t length_;
+    pla_function function_;
+    pla_function** outputs_;
+    struct pla_cache_entry* next_;
+} pla_cache_entry;
+
+/**
+ * @brief Remembers which contents a PLA file path resolved to.
+ *
+ * Fields:
+ * - path_: Path of the PLA file.
+ * - content_hash_: Hash of the file contents.
+ * - length_: Length of the file contents.
+ * - function_: Parse of the file with all outputs, kept only until it is stored in the cache.
+ * - entry_: Cache entry holding the contents of the file, NULL until stored.
+ * - read_: Whether reading the file was already attempted.
+ * - stored_: Whether function_ was already stored in the cache.
+ * - loaded_: Whether the file could be read and parsed.
+ */
+typedef struct pla_cache_path {
+    char* path_;
+    uint64_t content_hash_;
+    size_t length_;
+    pla_function function_;
+    pla_cache_entry* entry_;
+    _Bool read_;
+    _Bool stored_;
+    _Bool loaded_;
+} pla_cache_path;
+
+/**
+ * @brief Cache of parsed PLA functions keyed by file contents.
+ *
+ * Every distinct file is parsed once, every requested output column is
+ * extracted once. Files with the same hash and length share an entry only
+ * if their parsed functions are equal. Modules share the cached functions
+ * copy-on-write.
+ *
+ * Fields:
+ * - paths_: Array list of pla_cache_path pointers in registration order.
+ * - path_index_: Hash map from file paths to the records in paths_.
+ * - entries_: Array list of pla_cache_entry pointers.
+ * - entry_index_: Hash map from entry keys to the first entry with that key.
+ */
+typedef struct pla_cache {
+    array_list paths_;
+    hash_map path_index_;
+    array_list entries_;
+    hash_map entry_index_;
+} pla_cache;
+
+/**
+ * @brief Shared state of the threads loading PLA files into the cache.
+ *
+ * Fields:
+ * - cache_: Pointer to the PLA cache being loaded.
+ * - mutex_: Pointer to the mutex guarding next_path_.
+ * - next_path_: Index of the next path record to read.
+ */
+typedef struct pla_cache_loader {
+    pla_cache* cache_;
+    pthread_mutex_t* mutex_;
+    int next_path_;
+} pla_cache_loader;
+
+/**
+ * @brief Initializes an empty PLA cache.
+ * @param this Pointer to the PLA cache.
+ */
+void pla_cache_init(pla_cache* this);
+
+/**
+ * @brief Destroys the PLA cache.
+ *
+ * Functions shared from the cache stay valid, their storage is released
+ * by the last module referencing it.
+ * @param this Pointer to the PLA cache.
+ */
+void pla_cache_destroy(pla_cache* this);
+
+/**
+ * @brief Computes the hash used as the cache key of PLA file contents.
+ * @param text Pointer to the file contents.
+ * @param length Length of the contents.
+ * @return 64-bit FNV-1a hash of the contents.
+ */
+uint64_t pla_cache_hash(const char* text, size_t length);
+
+/**
+ * @brief Registers a PLA file to be read by the next pla_cache_load.
+ * @param this Pointer to the PLA cache.
+ * @param path Path to the PLA file.
+ */
+void pla_cache_add_path(pla_cache* this, const char* path);
+
+/**
+ * @brief Reads and parses all registered PLA files on several threads.
+ *
+ * Files are stored in the cache in the order they were registered, so the
+ * result does not depend on the scheduling of the threads.
+ * @param this Pointer to the PLA cache.
+ * @param thread_count Number of threads to use, values below 1 use the calling thread only.
+ */
+void pla_cache_load(pla_cache* this, int thread_count);
+
+/**
+ * @brief Gets a single-output PLA function from the cache, loading it if needed.
+ * @param this Pointer to the PLA cache.
+ * @param path Path to the PLA file.
+ * @param output_column Output column of the file.
+ * @return Pointer to the cached function, or NULL if it could not be loaded.
+ */
+pla_function* pla_cache_get(pla_cache* this, const char* path, int output_column);
+
+#endif //PLA_CACHE_H
@@ -4,11 +4,17 @@
 #include <unistd.h>
 #include "module_manager.h"
 #include "server_utils.h"
+#include "task_scheduler.h"
 
 void server_interface_init(server_interface* this) {
     setlocale(LC_ALL, "sk_SK.utf8");
     bdd_server_init(&this->server_);
     this->binded_ = false;
+    this->subtree_divide_ = false;
+    this->dynamic_tasks_ = false;
+    this->direct_transfers_ = true;
+    this->compress_transfers_ = false;
+    this->merge_mode_ = MODULE_MERGE_CUBES;
 }
 
 void server_interface_destroy(server_interface* this) {
@@ -50,6 +56,30 @@ void server_interface_start_interface(server_interface* this) {
             case 4:
                 server_interface_run(this);
                 break;
+            case 5:
+                this->subtree_divide_ = !this->subtree_divide_;
+                printf("Rozdelenie celých podstromov modulov je %s.\n", this->subtree_divide_ ? "zapnuté" : "vypnuté");
+                break;
+            case 6:
+                this->dynamic_tasks_ = !this->dynamic_tasks_;
+                printf("Dynamické rozdeľovanie úloh klientom je %s.\n", this->dynamic_tasks_ ? "zapnuté" : "vypnuté");
+                break;
+            case 7:
+                this->direct_transfers_ = !this->direct_transfers_;
+                printf("Priame posielanie modulov medzi klientmi je %s.\n", this->direct_transfers_ ? "zapnuté" : "vypnuté");
+                break;
+            case 8:
+                this->compress_transfers_ = !this->compress_transfers_;
+                printf("Kompresia prenášaných modulov je %s.\n", this->compress_transfers_ ? "zapnutá" : "vypnutá");
+                break;
+            case 9:
+                this->merge_mode_ = this->merge_mode_ == MODULE_MERGE_ON_SET ? MODULE_MERGE_CUBES : MODULE_MERGE_ON_SET;
+                printf("Spájanie iba jednotkových kociek (on-set) je %s.\n", this->merge_mode_ == MODULE_MERGE_ON_SET ? "zapnuté" : "vypnuté");
+                break;
+            case 10:
+                this->merge_mode_ = this->merge_mode_ == MODULE_MERGE_BDD ? MODULE_MERGE_CUBES : MODULE_MERGE_BDD;
+                printf("Spájanie pomocou BDD je %s.\n", this->merge_mode_ == MODULE_MERGE_BDD ? "zapnuté" : "vypnuté");
+                break;
             default:
                 printf("Zadali ste neplatnú možnosť, zadajte znovu.\n");
                 break;
@@ -65,6 +95,12 @@ void server_interface_print_menu(void) {
     printf("2 - Pripojiť klientov\n");
     printf("3 - Otestovať spojenia\n");
     printf("4 - Spustiť hlavný program\n");
+    printf("5 - Zapnúť/vypnúť rozdelenie celých podstromov modulov\n");
+    printf("6 - Zapnúť/vypnúť dynamické rozdeľovanie úloh klientom\n");
+    printf("7 - Zapnúť/vypnúť priame posielanie modulov medzi klientmi\n");
+    printf("8 - Zapnúť/vypnúť kompresiu prenášaných modulov\n");
+    printf("9 - Zapnúť/vypnúť spájanie iba jednotkových kociek (on-set)\n");
+    printf("10 - Zapnúť/vypnúť spájanie pomocou BDD\n");
     printf("0 - Ukončiť\n");
     printf("Vyberte možnosť: ");
 }
@@ -251,30 +287,62 @@ void server_interface_run(server_interface* this) {
     array_list* modules = module_manager_get_modules(&manager);
     int* distribution = calloc(client_count, sizeof(int));
 
-    divider_default_divide(modules, client_count, distribution);
-    module_manager_create_instructions(&manager, distribution, give_instruction);
-
-    if (bdd_server_send_instructions(&this->server_, module_manager_get_instructions(&manager))) {
-        bdd_server_send_modules(&this->server_, modules, distribution);
+    divider_plan plan;
+    if (this->subtree_divide_) {
+        divider_subtree_divide(modules, client_count, distribution, &plan);
+    } else {
+        divider_critical_path_divide(modules, client_count, distribution, &plan);
+    }
+    divider_plan_print(&plan);
+
+    task_scheduler scheduler;
+    _Bool sent;
+    if (this->dynamic_tasks_) {
+        task_scheduler_init(&scheduler, &plan);
+        char** instructions = malloc(client_count * sizeof(char*));
+        for (int i = 0; i < client_count; i++) {
+            instructions[i] = "DYNM\n";
+        }
+        sent = bdd_server_send_instructions(&this->server_, instructions);
+        free(instructions);
+    } else {
+        module_manager_create_instructions(&manager, distribution, give_instruction);
+        sent = bdd_server_send_instructions(&this->server_, module_manager_get_instructions(&manager));
+    }
 
+    if (sent) {
         bdd_message result;
         bdd_message_init(&result, 0);
 
-        bdd_server_execute_instructions(&this->server_, &result);
+        bdd_server_negotiate_compression(&this->server_, this->compress_transfers_);
+        bdd_server_send_merge_mode(&this->server_, this->merge_mode_);
+        if (this->dynamic_tasks_) {
+            bdd_server_execute_tasks(&this->server_, &scheduler, &result);
+            task_scheduler_print(&scheduler);
+        } else {
+            bdd_server_exchange_peers(&this->server_, this->direct_transfers_);
+            bdd_server_send_modules(&this->server_, modules, distribution);
+            bdd_server_execute_instructions(&this->server_, &result);
+        }
 
-        bdd_message_deserialize(&result, module_deserialize);
+        bdd_message_deserialize_in_place(&result, module_deserialize_in_place);
         module* mod = bdd_message_get_unique_payload(&result);
         bdd_message_destroy(&result);
 
         module_print_out(mod);
         module_destroy(mod);
         free(mod);
+        bdd_server_print_compression(&this->server_);
         printf("Hlavný program bol ukončený. Ukončuje sa aj spojenie s klientami.\n");
     } else {
         printf("Počas posielania dát sa klient odpojil od servera, výpočet sa nevykonal.\n");
         printf("Server odpája všetkých klientov.\n");
     }
 
+    if (this->dynamic_tasks_) {
+        task_scheduler_destroy(&scheduler);
+    }
+    divider_plan_destroy(&plan);
     free(distribution);
     module_manager_destroy(&manager);
     bdd_server_end_sessions(&this->server_);
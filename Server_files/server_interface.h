@@ -8,10 +8,24 @@
  * Fields:
  * - server_: Instance of the BDD server.
  * - binded_: Boolean indicating if the server is bound to an address and port.
+ * - subtree_divide_: Boolean indicating if whole subtrees are assigned to clients
+ *   instead of scheduling modules on the critical path.
+ * - dynamic_tasks_: Boolean indicating if merge tasks are handed out to clients
+ *   on demand instead of sending them fixed instructions.
+ * - direct_transfers_: Boolean indicating if clients send modules to each other
+ *   directly instead of through the server.
+ * - compress_transfers_: Boolean indicating if the server sends and accepts
+ *   compressed modules.
+ * - merge_mode_: Way all clients merge son functions in a run, see module_merge_sons.
  */
 typedef struct server_interface {
     bdd_server server_;
     _Bool binded_;
+    _Bool subtree_divide_;
+    _Bool dynamic_tasks_;
+    _Bool direct_transfers_;
+    _Bool compress_transfers_;
+    module_merge_mode merge_mode_;
 } server_interface;
 
 
@@ -1,4 +1,7 @@
 #include "server_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "../Shared/hash_map.h"
 
 void divider_default_divide(array_list* modules, int client_count, int* distribution) {
     array_list_iterator begin;
@@ -18,6 +21,365 @@ void divider_default_divide(array_list* modules, int client_count, int* distribu
     array_list_iterator_destroy(&end);
 }
 
+/**
+ * @brief Estimates and partial schedule shared by the module dividers.
+ *
+ * Fields:
+ * - entries_: Estimates of all modules, in the order of the module list.
+ * - order_: Entries sorted from the longest path to the root down, sons before their parent.
+ * - arrivals_: Time the last son of every entry can be on every client.
+ * - client_free_: Time every client finishes its last merge.
+ * - client_load_: Estimated merge cost of every client.
+ * - index_: Entries by module name.
+ * - count_: Number of modules.
+ * - client_count_: Number of clients.
+ * - makespan_: Estimated time the root module reaches the server.
+ */
+typedef struct divider_state {
+    divider_entry* entries_;
+    divider_entry** order_;
+    double* arrivals_;
+    double* client_free_;
+    double* client_load_;
+    hash_map index_;
+    int count_;
+    int client_count_;
+    double makespan_;
+} divider_state;
+
+static int divider_height_comparator(const void* this, const void* other) {
+    return module_get_priority((*(divider_entry**)this)->module_) - module_get_priority((*(divider_entry**)other)->module_);
+}
+
+static int divider_level_comparator(const void* this, const void* other) {
+    divider_entry* a = *(divider_entry**)this;
+    divider_entry* b = *(divider_entry**)other;
+    if (a->bottom_level_ != b->bottom_level_) {
+        return a->bottom_level_ < b->bottom_level_ ? 1 : -1;
+    }
+    return module_get_priority(a->module_) - module_get_priority(b->module_);
+}
+
+static divider_entry* divider_state_get_parent(divider_state* this, divider_entry* entry) {
+    module* parent = module_get_parent(entry->module_);
+    return parent ? hash_map_get(&this->index_, module_get_name(parent)) : NULL;
+}
+
+static _Bool divider_entry_is_leaf(divider_entry* entry) {
+    return module_get_son_count(entry->module_) == 0 && module_get_parent(entry->module_);
+}
+
+static void divider_state_init(divider_state* this, array_list* modules, int client_count) {
+    int count = array_list_get_size(modules);
+    this->entries_ = calloc(count > 0 ? count : 1, sizeof(divider_entry));
+    this->order_ = malloc((count > 0 ? count : 1) * sizeof(divider_entry*));
+    this->arrivals_ = calloc((size_t)(count > 0 ? count : 1) * client_count, sizeof(double));
+    this->client_free_ = calloc(client_count, sizeof(double));
+    this->client_load_ = calloc(client_count, sizeof(double));
+    this->count_ = count;
+    this->client_count_ = client_count;
+    this->makespan_ = 0;
+    hash_map_init(&this->index_);
+
+    divider_entry* entries = this->entries_;
+    divider_entry** order = this->order_;
+    for (int i = 0; i < count; i++) {
+        module* mod = NULL;
+        array_list_try_get(modules, i, &mod);
+        entries[i].module_ = mod;
+        order[i] = entries + i;
+        hash_map_put(&this->index_, module_get_name(mod), entries + i);
+    }
+
+    // Sons have a lower priority than their parent, so they are estimated first.
+    qsort(order, count, sizeof(divider_entry*), divider_height_comparator);
+    for (int i = 0; i < count; i++) {
+        divider_entry* entry = order[i];
+        double son_lines = entry->lines_;
+        entry->var_count_ += module_get_var_count(entry->module_);
+        int words = pla_function_words_per_cube(entry->var_count_);
+        entry->merge_cost_ = module_get_num_lines(entry->module_) * son_lines * (words > 0 ? words : 1);
+        entry->lines_ = module_get_num_lines(entry->module_) + son_lines;
+        entry->size_ = 4 * sizeof(int) + entry->lines_ * (words * sizeof(uint64_t) + 1);
+        entry->subtree_cost_ += entry->merge_cost_;
+
+        divider_entry* parent_entry = divider_state_get_parent(this, entry);
+        if (parent_entry) {
+            parent_entry->lines_ += entry->lines_;
+            parent_entry->var_count_ += entry->var_count_ - 1;
+            parent_entry->subtree_cost_ += entry->subtree_cost_;
+        }
+    }
+
+    for (int i = count - 1; i >= 0; i--) {
+        divider_entry* entry = order[i];
+        divider_entry* parent_entry = divider_state_get_parent(this, entry);
+        entry->bottom_level_ = entry->merge_cost_ + (parent_entry ? parent_entry->bottom_level_ : 0);
+    }
+
+    qsort(order, count, sizeof(divider_entry*), divider_level_comparator);
+}
+
+static double divider_state_get_finish(divider_state* this, divider_entry* entry, int client) {
+    double arrival = this->arrivals_[(size_t)(entry - this->entries_) * this->client_count_ + client];
+    double start = arrival > this->client_free_[client] ? arrival : this->client_free_[client];
+    return start + entry->merge_cost_;
+}
+
+static void divider_state_place(divider_state* this, divider_entry* entry, int client) {
+    double finish = divider_state_get_finish(this, entry, client);
+    module_set_client(entry->module_, client);
+    entry->finish_ = finish;
+    this->client_free_[client] = finish;
+    this->client_load_[client] += entry->merge_cost_;
+
+    double transfer = entry->size_ * DIVIDER_BYTE_COST;
+    divider_entry* parent_entry = divider_state_get_parent(this, entry);
+    if (parent_entry) {
+        double* parent_arrival = this->arrivals_ + (size_t)(parent_entry - this->entries_) * this->client_count_;
+        for (int i = 0; i < this->client_count_; i++) {
+            double time = finish + (i != client ? transfer : 0);
+            if (time > parent_arrival[i]) {
+                parent_arrival[i] = time;
+            }
+        }
+    } else if (finish + transfer > this->makespan_) {
+        this->makespan_ = finish + transfer;
+    }
+}
+
+static void divider_state_complete(divider_state* this, int* distribution, divider_plan* plan) {
+    int* client_modules = calloc(this->client_count_, sizeof(int));
+    double transfer_bytes = 0;
+    int transfer_count = 0;
+    for (int i = 0; i < this->count_; i++) {
+        module* mod = this->entries_[i].module_;
+        module* parent = module_get_parent(mod);
+        if (parent && module_get_son_count(mod) == 0) {
+            module_set_client(mod, module_get_assigned_client(parent));
+        } else if (parent && module_get_assigned_client(mod) != module_get_assigned_client(parent)) {
+            transfer_bytes += this->entries_[i].size_;
+            transfer_count++;
+        }
+        distribution[module_get_assigned_client(mod)]++;
+        client_modules[module_get_assigned_client(mod)]++;
+    }
+
+    if (plan) {
+        plan->entries_ = this->entries_;
+        plan->entry_count_ = this->count_;
+        plan->client_count_ = this->client_count_;
+        plan->client_modules_ = client_modules;
+        plan->client_load_ = this->client_load_;
+        plan->makespan_ = this->makespan_;
+        plan->transfer_bytes_ = transfer_bytes;
+        plan->transfer_count_ = transfer_count;
+    } else {
+        free(this->entries_);
+        free(client_modules);
+        free(this->client_load_);
+    }
+
+    hash_map_destroy(&this->index_);
+    free(this->client_free_);
+    free(this->arrivals_);
+    free(this->order_);
+}
+
+void divider_critical_path_divide(array_list* modules, int client_count, int* distribution, divider_plan* plan) {
+    divider_state state;
+    divider_state_init(&state, modules, client_count);
+
+    for (int i = 0; i < state.count_; i++) {
+        divider_entry* entry = state.order_[i];
+        if (divider_entry_is_leaf(entry)) {
+            continue;
+        }
+
+        int best_client = 0;
+        double best_finish = 0;
+        for (int client = 0; client < client_count; client++) {
+            double finish = divider_state_get_finish(&state, entry, client);
+            if (client == 0 || finish < best_finish || (finish == best_finish && state.client_free_[client] < state.client_free_[best_client])) {
+                best_client = client;
+                best_finish = finish;
+            }
+        }
+        divider_state_place(&state, entry, best_client);
+    }
+
+    divider_state_complete(&state, distribution, plan);
+}
+
+static int divider_subtree_comparator(const void* this, const void* other) {
+    divider_entry* a = *(divider_entry**)this;
+    divider_entry* b = *(divider_entry**)other;
+    if (a->subtree_cost_ != b->subtree_cost_) {
+        return a->subtree_cost_ < b->subtree_cost_ ? 1 : -1;
+    }
+    return (int)(a - b);
+}
+
+void divider_subtree_divide(array_list* modules, int client_count, int* distribution, divider_plan* plan) {
+    divider_state state;
+    divider_state_init(&state, modules, client_count);
+    int count = state.count_;
+    int size = count > 0 ? count : 1;
+    divider_entry* entries = state.entries_;
+
+    int* parents = malloc(size * sizeof(int));
+    int* son_offsets = calloc(size + 1, sizeof(int));
+    int* sons = malloc(size * sizeof(int));
+    int* clients = malloc(size * sizeof(int));
+    _Bool* cut = calloc(size, sizeof(_Bool));
+    int* frontier = malloc(size * sizeof(int));
+    int frontier_count = 0;
+
+    for (int i = 0; i < count; i++) {
+        divider_entry* parent_entry = divider_state_get_parent(&state, entries + i);
+        parents[i] = parent_entry ? (int)(parent_entry - entries) : -1;
+        if (parents[i] >= 0) {
+            son_offsets[parents[i] + 1]++;
+        }
+        clients[i] = -1;
+    }
+    for (int i = 0; i < count; i++) {
+        son_offsets[i + 1] += son_offsets[i];
+    }
+    int* son_fill = malloc(size * sizeof(int));
+    memcpy(son_fill, son_offsets, size * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        if (parents[i] >= 0) {
+            sons[son_fill[parents[i]]++] = i;
+        }
+    }
+    free(son_fill);
+
+    double total_cost = 0;
+    for (int i = 0; i < count; i++) {
+        if (parents[i] < 0) {
+            total_cost += entries[i].subtree_cost_;
+            frontier[frontier_count++] = i;
+        }
+    }
+
+    // Split the heaviest subtree into the subtrees of its sons until there are
+    // enough of them for every client and none is heavier than an even share.
+    // Leaves always stay with their parent, so only sons with sons are split off.
+    double share = total_cost / client_count;
+    while (true) {
+        int heaviest = -1;
+        for (int i = 0; i < frontier_count; i++) {
+            int entry = frontier[i];
+            _Bool splittable = false;
+            for (int j = son_offsets[entry]; j < son_offsets[entry + 1] && !splittable; j++) {
+                splittable = !divider_entry_is_leaf(entries + sons[j]);
+            }
+            if (splittable && (heaviest < 0 || entries[entry].subtree_cost_ > entries[frontier[heaviest]].subtree_cost_)) {
+                heaviest = i;
+            }
+        }
+        if (heaviest < 0 || (frontier_count >= client_count && entries[frontier[heaviest]].subtree_cost_ <= share)) {
+            break;
+        }
+
+        int entry = frontier[heaviest];
+        cut[entry] = true;
+        frontier[heaviest] = frontier[--frontier_count];
+        for (int j = son_offsets[entry]; j < son_offsets[entry + 1]; j++) {
+            if (!divider_entry_is_leaf(entries + sons[j])) {
+                frontier[frontier_count++] = sons[j];
+            }
+        }
+    }
+
+    // Longest processing time first: the heaviest subtrees go to the least loaded clients.
+    divider_entry** subtrees = malloc(size * sizeof(divider_entry*));
+    for (int i = 0; i < frontier_count; i++) {
+        subtrees[i] = entries + frontier[i];
+    }
+    qsort(subtrees, frontier_count, sizeof(divider_entry*), divider_subtree_comparator);
+    double* subtree_load = calloc(client_count, sizeof(double));
+    for (int i = 0; i < frontier_count; i++) {
+        int least_loaded = 0;
+        for (int client = 1; client < client_count; client++) {
+            if (subtree_load[client] < subtree_load[least_loaded]) {
+                least_loaded = client;
+            }
+        }
+        clients[subtrees[i] - entries] = least_loaded;
+        subtree_load[least_loaded] += subtrees[i]->subtree_cost_;
+    }
+    free(subtrees);
+
+    // Whole subtrees follow their root, parents come after sons in the order.
+    for (int i = count - 1; i >= 0; i--) {
+        int entry = (int)(state.order_[i] - entries);
+        if (clients[entry] < 0 && !cut[entry] && parents[entry] >= 0) {
+            clients[entry] = clients[parents[entry]];
+        }
+    }
+
+    // A module above the cut stays on the client holding the most bytes of its
+    // sons, so the fewest bytes of them cross the network.
+    double* son_bytes = subtree_load;
+    for (int i = 0; i < count; i++) {
+        int entry = (int)(state.order_[i] - entries);
+        if (!cut[entry]) {
+            continue;
+        }
+        memset(son_bytes, 0, client_count * sizeof(double));
+        for (int j = son_offsets[entry]; j < son_offsets[entry + 1]; j++) {
+            if (!divider_entry_is_leaf(entries + sons[j])) {
+                son_bytes[clients[sons[j]]] += entries[sons[j]].size_;
+            }
+        }
+        int best_client = 0;
+        for (int client = 1; client < client_count; client++) {
+            if (son_bytes[client] > son_bytes[best_client]) {
+                best_client = client;
+            }
+        }
+        clients[entry] = best_client;
+    }
+
+    for (int i = 0; i < count; i++) {
+        divider_entry* entry = state.order_[i];
+        if (!divider_entry_is_leaf(entry)) {
+            divider_state_place(&state, entry, clients[entry - entries]);
+        }
+    }
+
+    free(subtree_load);
+    free(frontier);
+    free(cut);
+    free(clients);
+    free(sons);
+    free(son_offsets);
+    free(parents);
+    divider_state_complete(&state, distribution, plan);
+}
+
+void divider_plan_destroy(divider_plan *this) {
+    free(this->entries_);
+    free(this->client_modules_);
+    free(this->client_load_);
+    this->entries_ = NULL;
+    this->client_modules_ = NULL;
+    this->client_load_ = NULL;
+    this->entry_count_ = 0;
+    this->client_count_ = 0;
+}
+
+void divider_plan_print(divider_plan *this) {
+    printf("Plán rozdelenia modulov:\n");
+    for (int i = 0; i < this->client_count_; i++) {
+        printf("Klient %d: %d modulov, odhadovaná záťaž %.0f\n", i, this->client_modules_[i], this->client_load_[i]);
+    }
+    printf("Odhadovaný čas dokončenia: %.0f\n", this->makespan_);
+    printf("Odhadovaný prenos medzi klientmi: %.0f B v %d presunoch\n", this->transfer_bytes_, this->transfer_count_);
+}
+
 void give_instruction(module *mod, char *instructions[2], int* distribution) {
     module* parent = module_get_parent(mod);
     if (parent) {
@@ -3,6 +3,60 @@
 #include "../Shared/module.h"
 #include "../Shared/array_list.h"
 
+/**
+ * @brief Cost of moving one byte between clients, relative to one word
+ * operation of a merge.
+ */
+#define DIVIDER_BYTE_COST 4.0
+
+/**
+ * @brief Estimates and schedule of one module.
+ *
+ * Fields:
+ * - module_: Pointer to the module.
+ * - lines_: Estimated number of lines after all merges into the module.
+ * - var_count_: Number of variables after all merges into the module.
+ * - merge_cost_: Estimated cost of merging the sons into the module.
+ * - size_: Estimated serialized size after all merges into the module.
+ * - subtree_cost_: Estimated cost of all merges in the subtree of the module.
+ * - bottom_level_: Estimated cost of the longest path from the module to the root.
+ * - finish_: Estimated time the merges into the module finish.
+ */
+typedef struct divider_entry {
+    module* module_;
+    double lines_;
+    int var_count_;
+    double merge_cost_;
+    double size_;
+    double subtree_cost_;
+    double bottom_level_;
+    double finish_;
+} divider_entry;
+
+/**
+ * @brief Plan of a module distribution with its estimated costs.
+ *
+ * Fields:
+ * - entries_: Estimates of all modules.
+ * - entry_count_: Number of modules.
+ * - client_count_: Number of clients.
+ * - client_modules_: Number of modules assigned to every client.
+ * - client_load_: Estimated merge cost of every client.
+ * - makespan_: Estimated time the root module reaches the server.
+ * - transfer_bytes_: Estimated bytes sent between clients.
+ * - transfer_count_: Number of modules sent between clients.
+ */
+typedef struct divider_plan {
+    divider_entry* entries_;
+    int entry_count_;
+    int client_count_;
+    int* client_modules_;
+    double* client_load_;
+    double makespan_;
+    double transfer_bytes_;
+    int transfer_count_;
+} divider_plan;
+
 /**
  * @brief Distributes modules among clients using a round-robin approach.
  * @param modules Pointer to an array list of modules.
@@ -11,6 +65,49 @@
  */
 void divider_default_divide(array_list* modules, int client_count, int* distribution);
 
+/**
+ * @brief Distributes modules among clients to minimize the estimated makespan.
+ *
+ * Merge costs are estimated from the line and variable counts of the
+ * functions, transfer costs from their estimated serialized size. Modules
+ * with sons are scheduled from the longest path to the root down, every one
+ * on the client where its merges would finish first, including the time to
+ * receive sons from other clients. Leaves are assigned to their parent's client.
+ * @param modules Pointer to an array list of modules with loaded functions.
+ * @param client_count Total number of clients.
+ * @param distribution Array to store the distribution of modules per client.
+ * @param plan Pointer to an uninitialized plan that receives the estimates, or NULL.
+ */
+void divider_critical_path_divide(array_list* modules, int client_count, int* distribution, divider_plan* plan);
+
+/**
+ * @brief Distributes whole subtrees of modules among clients to minimize the
+ * bytes sent between them.
+ *
+ * The heaviest subtree is split into the subtrees of its sons until there is
+ * one for every client and none exceeds an even share of the estimated merge
+ * cost. The subtrees are assigned heaviest first to the least loaded client,
+ * and the modules above them to the client holding most bytes of their sons,
+ * so only the cut edges cross the network.
+ * @param modules Pointer to an array list of modules with loaded functions.
+ * @param client_count Total number of clients.
+ * @param distribution Array to store the distribution of modules per client.
+ * @param plan Pointer to an uninitialized plan that receives the estimates, or NULL.
+ */
+void divider_subtree_divide(array_list* modules, int client_count, int* distribution, divider_plan* plan);
+
+/**
+ * @brief Destroys a plan of a module distribution.
+ * @param this Pointer to the plan.
+ */
+void divider_plan_destroy(divider_plan* this);
+
+/**
+ * @brief Prints the estimated load of every client and the estimated makespan.
+ * @param this Pointer to the plan.
+ */
+void divider_plan_print(divider_plan* this);
+
 /**
  * @brief Generates instructions for module communication and merging.
  * @param mod Pointer to the current module.
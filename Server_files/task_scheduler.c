@@ -0,0 +1,255 @@
+#include "task_scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static _Bool task_scheduler_is_task(divider_entry* entry) {
+    return module_get_son_count(entry->module_) > 0 || !module_get_parent(entry->module_);
+}
+
+void task_scheduler_init(task_scheduler* this, divider_plan* plan) {
+    this->task_count_ = 0;
+    for (int i = 0; i < plan->entry_count_; i++) {
+        this->task_count_ += task_scheduler_is_task(plan->entries_ + i);
+    }
+    this->tasks_ = calloc(this->task_count_ > 0 ? this->task_count_ : 1, sizeof(scheduler_task));
+    this->client_count_ = plan->client_count_;
+    this->running_ = calloc(this->client_count_, sizeof(scheduler_task*));
+    this->executed_ = calloc(this->client_count_, sizeof(int));
+    this->stolen_ = calloc(this->client_count_, sizeof(int));
+    this->finished_ = false;
+    hash_map_init(&this->index_);
+    pthread_mutex_init(&this->mutex_, NULL);
+    pthread_cond_init(&this->changed_, NULL);
+
+    scheduler_task* task = this->tasks_;
+    for (int i = 0; i < plan->entry_count_; i++) {
+        divider_entry* entry = plan->entries_ + i;
+        if (!task_scheduler_is_task(entry)) {
+            continue;
+        }
+        task->module_ = entry->module_;
+        task->entry_ = entry;
+        task->home_ = module_get_assigned_client(entry->module_);
+        task->client_ = -1;
+        task->holder_ = -1;
+        task->state_ = SCHEDULER_TASK_WAITING;
+        bdd_message_init(&task->result_, 0);
+        hash_map_put(&this->index_, module_get_name(entry->module_), task);
+        task++;
+    }
+
+    for (int i = 0; i < plan->entry_count_; i++) {
+        module* parent = module_get_parent(plan->entries_[i].module_);
+        if (parent) {
+            scheduler_task* parent_task = hash_map_get(&this->index_, module_get_name(parent));
+            if (task_scheduler_is_task(plan->entries_ + i)) {
+                parent_task->son_count_++;
+            } else {
+                parent_task->leaf_count_++;
+            }
+        }
+    }
+
+    for (int i = 0; i < this->task_count_; i++) {
+        task = this->tasks_ + i;
+        task->sons_ = malloc((task->son_count_ > 0 ? task->son_count_ : 1) * sizeof(scheduler_task*));
+        task->leaves_ = malloc((task->leaf_count_ > 0 ? task->leaf_count_ : 1) * sizeof(module*));
+        task->waiting_sons_ = task->son_count_;
+        task->state_ = task->son_count_ == 0 ? SCHEDULER_TASK_READY : SCHEDULER_TASK_WAITING;
+        task->son_count_ = 0;
+        task->leaf_count_ = 0;
+    }
+
+    for (int i = 0; i < plan->entry_count_; i++) {
+        module* mod = plan->entries_[i].module_;
+        module* parent = module_get_parent(mod);
+        if (parent) {
+            scheduler_task* parent_task = hash_map_get(&this->index_, module_get_name(parent));
+            if (task_scheduler_is_task(plan->entries_ + i)) {
+                task = hash_map_get(&this->index_, module_get_name(mod));
+                task->parent_ = parent_task;
+                parent_task->sons_[parent_task->son_count_++] = task;
+            } else {
+                parent_task->leaves_[parent_task->leaf_count_++] = mod;
+            }
+        }
+    }
+}
+
+void task_scheduler_destroy(task_scheduler* this) {
+    for (int i = 0; i < this->task_count_; i++) {
+        free(this->tasks_[i].sons_);
+        free(this->tasks_[i].leaves_);
+        bdd_message_destroy(&this->tasks_[i].result_);
+    }
+    free(this->tasks_);
+    free(this->running_);
+    free(this->executed_);
+    free(this->stolen_);
+    this->tasks_ = NULL;
+    this->running_ = NULL;
+    this->executed_ = NULL;
+    this->stolen_ = NULL;
+    this->task_count_ = 0;
+    hash_map_destroy(&this->index_);
+    pthread_cond_destroy(&this->changed_);
+    pthread_mutex_destroy(&this->mutex_);
+}
+
+static scheduler_task* task_scheduler_find_ready(task_scheduler* this, int client) {
+    scheduler_task* best = NULL;
+    for (int i = 0; i < this->task_count_; i++) {
+        scheduler_task* task = this->tasks_ + i;
+        if (task->state_ == SCHEDULER_TASK_READY && task->home_ == client &&
+            (!best || task->entry_->bottom_level_ > best->entry_->bottom_level_)) {
+            best = task;
+        }
+    }
+    return best;
+}
+
+static void task_scheduler_move_subtree(task_scheduler* this, scheduler_task* task, int from, int to) {
+    task->home_ = to;
+    this->stolen_[to]++;
+    for (int i = 0; i < task->son_count_; i++) {
+        if (task->sons_[i]->home_ == from) {
+            task_scheduler_move_subtree(this, task->sons_[i], from, to);
+        }
+    }
+}
+
+static scheduler_task* task_scheduler_steal_subtree(task_scheduler* this, int client) {
+    scheduler_task* best = NULL;
+    for (int i = 0; i < this->task_count_; i++) {
+        scheduler_task* task = this->tasks_ + i;
+        // Only whole subtrees of a busy client, which it would not start before its current task finishes.
+        if (task->touched_ || task->home_ == client || !this->running_[task->home_]) {
+            continue;
+        }
+        if (task->parent_ && !task->parent_->touched_ && task->parent_->home_ == task->home_) {
+            continue;
+        }
+        if (!best || task->entry_->subtree_cost_ > best->entry_->subtree_cost_) {
+            best = task;
+        }
+    }
+    if (best) {
+        task_scheduler_move_subtree(this, best, best->home_, client);
+        return task_scheduler_find_ready(this, client);
+    }
+    return NULL;
+}
+
+static scheduler_task* task_scheduler_steal_task(task_scheduler* this, int client) {
+    scheduler_task* best = NULL;
+    for (int i = 0; i < this->task_count_; i++) {
+        scheduler_task* task = this->tasks_ + i;
+        if (task->state_ != SCHEDULER_TASK_READY || task->home_ == client || !this->running_[task->home_]) {
+            continue;
+        }
+        _Bool on_server = true;
+        for (int j = 0; j < task->son_count_ && on_server; j++) {
+            on_server = task->sons_[j]->holder_ < 0;
+        }
+        if (on_server && (!best || task->entry_->bottom_level_ > best->entry_->bottom_level_)) {
+            best = task;
+        }
+    }
+    return best;
+}
+
+static char* task_scheduler_create_script(scheduler_task* task, int client) {
+    char* name = module_get_name(task->module_);
+    size_t name_length = strlen(name);
+    size_t size = 2 * (name_length + 6) + 1;
+    for (int i = 0; i < task->leaf_count_; i++) {
+        size += 2 * strlen(module_get_name(task->leaves_[i])) + name_length + 14;
+    }
+    for (int i = 0; i < task->son_count_; i++) {
+        size += 2 * strlen(module_get_name(task->sons_[i]->module_)) + name_length + 14;
+    }
+
+    char* script = malloc(size);
+    size_t length = snprintf(script, size, "RECV %s\n", name);
+    for (int i = 0; i < task->leaf_count_; i++) {
+        length += snprintf(script + length, size - length, "RECV %s\n", module_get_name(task->leaves_[i]));
+    }
+    for (int i = 0; i < task->son_count_; i++) {
+        if (task->sons_[i]->holder_ < 0) {
+            length += snprintf(script + length, size - length, "RECV %s\n", module_get_name(task->sons_[i]->module_));
+        }
+    }
+    for (int i = 0; i < task->leaf_count_; i++) {
+        length += snprintf(script + length, size - length, "MERG %s %s\n", name, module_get_name(task->leaves_[i]));
+    }
+    for (int i = 0; i < task->son_count_; i++) {
+        length += snprintf(script + length, size - length, "MERG %s %s\n", name, module_get_name(task->sons_[i]->module_));
+    }
+
+    const char* end = !task->parent_ ? "END" : (task->parent_->home_ == client ? "DONE" : "UPLD");
+    snprintf(script + length, size - length, "%s %s\n", end, name);
+    return script;
+}
+
+scheduler_task* task_scheduler_next(task_scheduler* this, int client, char** script) {
+    pthread_mutex_lock(&this->mutex_);
+    scheduler_task* task = NULL;
+    while (!this->finished_) {
+        task = task_scheduler_find_ready(this, client);
+        if (!task) {
+            task = task_scheduler_steal_subtree(this, client);
+        }
+        if (!task) {
+            task = task_scheduler_steal_task(this, client);
+        }
+        if (task) {
+            break;
+        }
+        pthread_cond_wait(&this->changed_, &this->mutex_);
+    }
+
+    if (task) {
+        if (task->home_ != client) {
+            this->stolen_[client]++;
+        }
+        task->state_ = SCHEDULER_TASK_RUNNING;
+        task->client_ = client;
+        this->running_[client] = task;
+        for (scheduler_task* touched = task; touched && !touched->touched_; touched = touched->parent_) {
+            touched->touched_ = true;
+        }
+        *script = task_scheduler_create_script(task, client);
+    }
+    pthread_mutex_unlock(&this->mutex_);
+    return task;
+}
+
+void task_scheduler_complete(task_scheduler* this, scheduler_task* task, bdd_message* result) {
+    pthread_mutex_lock(&this->mutex_);
+    task->state_ = SCHEDULER_TASK_DONE;
+    if (result) {
+        task->result_ = *result;
+        bdd_message_init(result, 0);
+        task->holder_ = -1;
+    } else {
+        task->holder_ = task->client_;
+    }
+    this->running_[task->client_] = NULL;
+    this->executed_[task->client_]++;
+
+    if (!task->parent_) {
+        this->finished_ = true;
+    } else if (--task->parent_->waiting_sons_ == 0) {
+        task->parent_->state_ = SCHEDULER_TASK_READY;
+    }
+    pthread_cond_broadcast(&this->changed_);
+    pthread_mutex_unlock(&this->mutex_);
+}
+
+void task_scheduler_print(task_scheduler* this) {
+    printf("Dynamické rozdelenie úloh:\n");
+    for (int i = 0; i < this->client_count_; i++) {
+        printf("Klient %d: %d úloh, z toho %d prevzatých od iných klientov\n", i, this->executed_[i], this->stolen_[i]);
+    }
+}
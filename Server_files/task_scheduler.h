@@ -0,0 +1,139 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+#include <pthread.h>
+#include "../Shared/bdd_message.h"
+#include "../Shared/hash_map.h"
+#include "../Shared/module.h"
+#include "server_utils.h"
+
+/**
+ * @brief State of a scheduler_task.
+ *
+ * Values:
+ * - SCHEDULER_TASK_WAITING: Merges of some sons did not finish yet.
+ * - SCHEDULER_TASK_READY: All sons are merged, the task can be handed out.
+ * - SCHEDULER_TASK_RUNNING: The task was handed out to a client.
+ * - SCHEDULER_TASK_DONE: The client reported the task finished.
+ */
+typedef enum scheduler_task_state {
+    SCHEDULER_TASK_WAITING,
+    SCHEDULER_TASK_READY,
+    SCHEDULER_TASK_RUNNING,
+    SCHEDULER_TASK_DONE
+} scheduler_task_state;
+
+/**
+ * @brief Merge of all sons into one module with sons, handed out to a client as a whole.
+ *
+ * Fields:
+ * - module_: Pointer to the module the sons are merged into.
+ * - entry_: Estimates of the module, see divider_entry.
+ * - parent_: Task of the parent module, or NULL for the root.
+ * - sons_: Tasks of the sons with sons.
+ * - son_count_: Number of tasks in sons_.
+ * - leaves_: Sons without sons, always sent from the server.
+ * - leaf_count_: Number of modules in leaves_.
+ * - waiting_sons_: Number of tasks in sons_ not done yet.
+ * - home_: Client the task is planned on.
+ * - client_: Client the task was handed out to, or -1.
+ * - holder_: Client keeping the merged module, or -1 when it was uploaded to the server.
+ * - state_: State of the task.
+ * - touched_: Whether the task or any task below it was handed out.
+ * - result_: Serialized merged module uploaded to the server.
+ */
+typedef struct scheduler_task {
+    module* module_;
+    divider_entry* entry_;
+    struct scheduler_task* parent_;
+    struct scheduler_task** sons_;
+    int son_count_;
+    module** leaves_;
+    int leaf_count_;
+    int waiting_sons_;
+    int home_;
+    int client_;
+    int holder_;
+    scheduler_task_state state_;
+    _Bool touched_;
+    bdd_message result_;
+} scheduler_task;
+
+/**
+ * @brief Hands out merge tasks to clients on demand.
+ *
+ * Every client runs the ready tasks planned on it first, critical path
+ * first. An idle client then takes over the largest subtree not started
+ * yet from a busy client, and failing that a single ready task whose sons
+ * are all on the server. A merged module stays on its client when the
+ * parent is planned there, otherwise it is uploaded to the server and sent
+ * on together with the parent task.
+ *
+ * Fields:
+ * - tasks_: Array of all tasks.
+ * - task_count_: Number of tasks.
+ * - index_: Hash map from module names to their tasks.
+ * - client_count_: Number of clients.
+ * - running_: Task every client runs, or NULL.
+ * - executed_: Number of tasks every client ran.
+ * - stolen_: Number of tasks every client took over from other clients.
+ * - mutex_: Mutex guarding the tasks.
+ * - changed_: Signaled when a task becomes ready or the root is done.
+ * - finished_: Whether the root task is done.
+ */
+typedef struct task_scheduler {
+    scheduler_task* tasks_;
+    int task_count_;
+    hash_map index_;
+    int client_count_;
+    scheduler_task** running_;
+    int* executed_;
+    int* stolen_;
+    pthread_mutex_t mutex_;
+    pthread_cond_t changed_;
+    _Bool finished_;
+} task_scheduler;
+
+/**
+ * @brief Initializes a task scheduler from a module distribution.
+ *
+ * The clients assigned by the divider become the home clients of the tasks.
+ * @param this Pointer to the task scheduler.
+ * @param plan Pointer to the plan of the distribution, must outlive the scheduler.
+ */
+void task_scheduler_init(task_scheduler* this, divider_plan* plan);
+
+/**
+ * @brief Destroys a task scheduler and the uploaded modules.
+ * @param this Pointer to the task scheduler.
+ */
+void task_scheduler_destroy(task_scheduler* this);
+
+/**
+ * @brief Waits for the next task of a client.
+ *
+ * The script of the task receives the modules the client does not have,
+ * merges the sons and ends with "DONE module" when the merged module stays
+ * on the client, "UPLD module" when it is uploaded to the server or
+ * "END module" for the root.
+ * @param this Pointer to the task scheduler.
+ * @param client ID of the client.
+ * @param script Pointer receiving the dynamically allocated script of the task.
+ * @return Pointer to the task, or NULL when the root is done.
+ */
+scheduler_task* task_scheduler_next(task_scheduler* this, int client, char** script);
+
+/**
+ * @brief Marks a task done and releases its parent.
+ * @param this Pointer to the task scheduler.
+ * @param task Pointer to the task.
+ * @param result Pointer to the uploaded module whose buffer is taken over, or NULL when it stays on the client.
+ */
+void task_scheduler_complete(task_scheduler* this, scheduler_task* task, bdd_message* result);
+
+/**
+ * @brief Prints the number of tasks every client ran and took over.
+ * @param this Pointer to the task scheduler.
+ */
+void task_scheduler_print(task_scheduler* this);
+
+#endif //TASK_SCHEDULER_H
@@ -233,6 +233,34 @@ size_t array_list_serialize(void *payload, void **serialized_payload,
     return total_size;
 }
 
+size_t array_list_write(const array_list *this, char *buffer, size_t(*write_item)(void *item, char *buffer)) {
+    size_t total_size = sizeof(int) * 3;
+    char* cursor = buffer;
+
+    if (cursor) {
+        memcpy(cursor, &this->size_, sizeof(int));
+        cursor += sizeof(int);
+        memcpy(cursor, &this->element_size_, sizeof(int));
+        cursor += sizeof(int);
+        memcpy(cursor, &this->capacity_, sizeof(int));
+        cursor += sizeof(int);
+    }
+
+    for (int i = 0; i < this->size_; i++) {
+        void* item = (char*)this->array_ + i * this->element_size_;
+        size_t item_size = write_item(item, NULL);
+        total_size += sizeof(size_t) + item_size;
+        if (cursor) {
+            memcpy(cursor, &item_size, sizeof(size_t));
+            cursor += sizeof(size_t);
+            write_item(item, cursor);
+            cursor += item_size;
+        }
+    }
+
+    return total_size;
+}
+
 void * array_list_deserialize(const void *serialized_payload, size_t size,
     void *(*deserialize_item)(const void *serialized_item, size_t item_size)) {
     const char* cursor = serialized_payload;
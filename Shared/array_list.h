@@ -96,6 +96,15 @@ size_t array_list_serialize(void* payload, void** serialized_payload, size_t(*se
  */
 void* array_list_deserialize(const void* serialized_payload, size_t size, void* (*deserialize_item)(const void* serialized_item, size_t item_size));
 
+/**
+ * @brief Writes the array list in the format of array_list_serialize directly into a buffer.
+ * @param this Pointer to the array list.
+ * @param buffer Output buffer, or NULL to only compute the size.
+ * @param write_item Function writing one item, returning its size and writing nothing for a NULL buffer.
+ * @return Size of the serialized data.
+ */
+size_t array_list_write(const array_list* this, char* buffer, size_t(*write_item)(void* item, char* buffer));
+
 
 array_list_iterator* array_list_get_begin(const array_list *this, array_list_iterator *begin);
 array_list_iterator* array_list_get_end(const array_list *this, array_list_iterator *end);
@@ -0,0 +1,358 @@
+#include "bdd.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BDD_DEFAULT_CAPACITY 1024
+#define BDD_CACHE_SIZE (1 << 16)
+
+#define BDD_OPERATION_ITE 1
+#define BDD_OPERATION_RESTRICT_0 2
+#define BDD_OPERATION_RESTRICT_1 3
+
+static uint64_t bdd_hash(int a, int b, int c) {
+    uint64_t hash = (uint64_t)(uint32_t)a * UINT64_C(0x9E3779B97F4A7C15);
+    hash ^= (uint64_t)(uint32_t)b * UINT64_C(0xC2B2AE3D27D4EB4F);
+    hash ^= (uint64_t)(uint32_t)c * UINT64_C(0x165667B19E3779F9);
+    return hash ^ (hash >> 32);
+}
+
+static void bdd_manager_insert_unique(bdd_manager* this, int node) {
+    bdd_node* n = this->nodes_ + node;
+    int slot = (int)(bdd_hash(n->var_, n->low_, n->high_) & this->unique_mask_);
+    while (this->unique_[slot] >= 0) {
+        slot = (slot + 1) & this->unique_mask_;
+    }
+    this->unique_[slot] = node;
+}
+
+static void bdd_manager_grow(bdd_manager* this) {
+    this->node_capacity_ *= 2;
+    this->nodes_ = realloc(this->nodes_, this->node_capacity_ * sizeof(bdd_node));
+
+    free(this->unique_);
+    this->unique_mask_ = 2 * this->node_capacity_ - 1;
+    this->unique_ = malloc((this->unique_mask_ + 1) * sizeof(int));
+    memset(this->unique_, -1, (this->unique_mask_ + 1) * sizeof(int));
+    for (int i = 2; i < this->node_count_; i++) {
+        bdd_manager_insert_unique(this, i);
+    }
+}
+
+static int bdd_manager_cache_find(bdd_manager* this, int operation, int f, int g, int h) {
+    bdd_cache_entry* entry = this->cache_ + (bdd_hash(f, g, h ^ (operation << 28)) & this->cache_mask_);
+    if (entry->operation_ == operation && entry->f_ == f && entry->g_ == g && entry->h_ == h) {
+        return entry->result_;
+    }
+    return -1;
+}
+
+static void bdd_manager_cache_store(bdd_manager* this, int operation, int f, int g, int h, int result) {
+    bdd_cache_entry* entry = this->cache_ + (bdd_hash(f, g, h ^ (operation << 28)) & this->cache_mask_);
+    entry->operation_ = operation;
+    entry->f_ = f;
+    entry->g_ = g;
+    entry->h_ = h;
+    entry->result_ = result;
+}
+
+static int bdd_manager_top_var(bdd_manager* this, int f, int g, int h) {
+    int var = this->nodes_[f].var_;
+    if (this->nodes_[g].var_ < var) {
+        var = this->nodes_[g].var_;
+    }
+    if (this->nodes_[h].var_ < var) {
+        var = this->nodes_[h].var_;
+    }
+    return var;
+}
+
+static int bdd_manager_cofactor(bdd_manager* this, int f, int var, int value) {
+    bdd_node* node = this->nodes_ + f;
+    if (node->var_ != var) {
+        return f;
+    }
+    return value ? node->high_ : node->low_;
+}
+
+void bdd_manager_init(bdd_manager *this) {
+    this->node_capacity_ = BDD_DEFAULT_CAPACITY;
+    this->nodes_ = malloc(this->node_capacity_ * sizeof(bdd_node));
+    this->nodes_[BDD_FALSE] = (bdd_node){ BDD_TERMINAL_VAR, BDD_FALSE, BDD_FALSE };
+    this->nodes_[BDD_TRUE] = (bdd_node){ BDD_TERMINAL_VAR, BDD_TRUE, BDD_TRUE };
+    this->node_count_ = 2;
+
+    this->unique_mask_ = 2 * this->node_capacity_ - 1;
+    this->unique_ = malloc((this->unique_mask_ + 1) * sizeof(int));
+    memset(this->unique_, -1, (this->unique_mask_ + 1) * sizeof(int));
+
+    this->cache_mask_ = BDD_CACHE_SIZE - 1;
+    this->cache_ = calloc(BDD_CACHE_SIZE, sizeof(bdd_cache_entry));
+}
+
+void bdd_manager_destroy(bdd_manager *this) {
+    free(this->nodes_);
+    free(this->unique_);
+    free(this->cache_);
+    this->nodes_ = NULL;
+    this->unique_ = NULL;
+    this->cache_ = NULL;
+    this->node_count_ = 0;
+    this->node_capacity_ = 0;
+}
+
+int bdd_manager_make_node(bdd_manager *this, int var, int low, int high) {
+    if (low == high) {
+        return low;
+    }
+
+    int slot = (int)(bdd_hash(var, low, high) & this->unique_mask_);
+    for (; this->unique_[slot] >= 0; slot = (slot + 1) & this->unique_mask_) {
+        bdd_node* node = this->nodes_ + this->unique_[slot];
+        if (node->var_ == var && node->low_ == low && node->high_ == high) {
+            return this->unique_[slot];
+        }
+    }
+
+    if (this->node_count_ == this->node_capacity_) {
+        bdd_manager_grow(this);
+    }
+    int index = this->node_count_++;
+    this->nodes_[index] = (bdd_node){ var, low, high };
+    bdd_manager_insert_unique(this, index);
+    return index;
+}
+
+int bdd_manager_ite(bdd_manager *this, int f, int g, int h) {
+    if (f == BDD_TRUE) {
+        return g;
+    }
+    if (f == BDD_FALSE) {
+        return h;
+    }
+    if (g == h) {
+        return g;
+    }
+    if (g == BDD_TRUE && h == BDD_FALSE) {
+        return f;
+    }
+
+    int cached = bdd_manager_cache_find(this, BDD_OPERATION_ITE, f, g, h);
+    if (cached >= 0) {
+        return cached;
+    }
+
+    int var = bdd_manager_top_var(this, f, g, h);
+    int low = bdd_manager_ite(this, bdd_manager_cofactor(this, f, var, 0), bdd_manager_cofactor(this, g, var, 0), bdd_manager_cofactor(this, h, var, 0));
+    int high = bdd_manager_ite(this, bdd_manager_cofactor(this, f, var, 1), bdd_manager_cofactor(this, g, var, 1), bdd_manager_cofactor(this, h, var, 1));
+    int result = bdd_manager_make_node(this, var, low, high);
+
+    bdd_manager_cache_store(this, BDD_OPERATION_ITE, f, g, h, result);
+    return result;
+}
+
+int bdd_manager_restrict(bdd_manager *this, int f, int var, int value) {
+    bdd_node node = this->nodes_[f];
+    if (node.var_ > var) {
+        return f;
+    }
+    if (node.var_ == var) {
+        return value ? node.high_ : node.low_;
+    }
+
+    int operation = value ? BDD_OPERATION_RESTRICT_1 : BDD_OPERATION_RESTRICT_0;
+    int cached = bdd_manager_cache_find(this, operation, f, var, 0);
+    if (cached >= 0) {
+        return cached;
+    }
+
+    int low = bdd_manager_restrict(this, node.low_, var, value);
+    int high = bdd_manager_restrict(this, node.high_, var, value);
+    int result = bdd_manager_make_node(this, node.var_, low, high);
+
+    bdd_manager_cache_store(this, operation, f, var, 0, result);
+    return result;
+}
+
+int bdd_manager_compose(bdd_manager *this, int f, int var, int g) {
+    int high = bdd_manager_restrict(this, f, var, 1);
+    int low = bdd_manager_restrict(this, f, var, 0);
+    return bdd_manager_ite(this, g, high, low);
+}
+
+static int bdd_manager_from_cubes(bdd_manager* this, int* cubes, int count) {
+    if (count == 0) {
+        return BDD_FALSE;
+    }
+    if (count == 1) {
+        return cubes[0];
+    }
+    int half = count / 2;
+    int low = bdd_manager_from_cubes(this, cubes, half);
+    int high = bdd_manager_from_cubes(this, cubes + half, count - half);
+    return bdd_manager_ite(this, low, BDD_TRUE, high);
+}
+
+int bdd_manager_from_pla(bdd_manager *this, pla_function *function, const int *var_map) {
+    int var_count = pla_function_get_var_count(function);
+    int line_count = pla_function_get_num_lines(function);
+    int* cubes = malloc((line_count > 0 ? line_count : 1) * sizeof(int));
+    int cube_count = 0;
+
+    // Cubes are built from the last variable of the order up, so the positions are visited in that order.
+    int* order = malloc((var_count > 0 ? var_count : 1) * sizeof(int));
+    for (int i = 0; i < var_count; i++) {
+        int position = i;
+        int j = i;
+        for (; j > 0 && var_map[order[j - 1]] < var_map[position]; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = position;
+    }
+
+    for (int i = 0; i < line_count; i++) {
+        if (pla_function_get_value(function, i) != '1') {
+            continue;
+        }
+        uint64_t* cube = pla_function_get_cube(function, i);
+        int node = BDD_TRUE;
+        for (int j = 0; j < var_count; j++) {
+            int position = order[j];
+            int literal = pla_cube_get_literal(cube, position);
+            if (literal == PLA_LITERAL_ZERO) {
+                node = bdd_manager_make_node(this, var_map[position], node, BDD_FALSE);
+            } else if (literal == PLA_LITERAL_ONE) {
+                node = bdd_manager_make_node(this, var_map[position], BDD_FALSE, node);
+            }
+        }
+        cubes[cube_count++] = node;
+    }
+
+    int result = bdd_manager_from_cubes(this, cubes, cube_count);
+    free(order);
+    free(cubes);
+    return result;
+}
+
+static size_t bdd_manager_count_paths(bdd_manager* this, int f, size_t* counts) {
+    if (f == BDD_FALSE || f == BDD_TRUE) {
+        return f;
+    }
+    if (counts[f] == SIZE_MAX) {
+        size_t low = bdd_manager_count_paths(this, this->nodes_[f].low_, counts);
+        size_t high = bdd_manager_count_paths(this, this->nodes_[f].high_, counts);
+        counts[f] = low > BDD_MAX_PLA_LINES || high > BDD_MAX_PLA_LINES - low ? BDD_MAX_PLA_LINES + 1 : low + high;
+    }
+    return counts[f];
+}
+
+static void bdd_manager_write_paths(bdd_manager* this, int f, uint64_t* cube, pla_function* result, int* line_num) {
+    if (f == BDD_FALSE) {
+        return;
+    }
+    if (f == BDD_TRUE) {
+        pla_function_add_cube(result, cube, '1', (*line_num)++);
+        return;
+    }
+    bdd_node node = this->nodes_[f];
+    pla_cube_set_literal(cube, node.var_, PLA_LITERAL_ZERO);
+    bdd_manager_write_paths(this, node.low_, cube, result, line_num);
+    pla_cube_set_literal(cube, node.var_, PLA_LITERAL_ONE);
+    bdd_manager_write_paths(this, node.high_, cube, result, line_num);
+    pla_cube_set_literal(cube, node.var_, PLA_LITERAL_DONT_CARE);
+}
+
+_Bool bdd_manager_to_pla(bdd_manager *this, int f, int var_count, pla_function *result) {
+    size_t* counts = malloc(this->node_count_ * sizeof(size_t));
+    for (int i = 0; i < this->node_count_; i++) {
+        counts[i] = SIZE_MAX;
+    }
+    size_t path_count = bdd_manager_count_paths(this, f, counts);
+    free(counts);
+    if (path_count > BDD_MAX_PLA_LINES) {
+        return false;
+    }
+
+    pla_function_init(result, var_count, (int)path_count);
+
+    int words = pla_function_words_per_cube(var_count);
+    uint64_t cube[words > 0 ? words : 1];
+    memset(cube, 0, sizeof(cube));
+    for (int position = 0; position < var_count; position++) {
+        pla_cube_set_literal(cube, position, PLA_LITERAL_DONT_CARE);
+    }
+    int line_num = 0;
+    bdd_manager_write_paths(this, f, cube, result, &line_num);
+    return true;
+}
+
+_Bool bdd_input_variables(pla_function *this, pla_function **others, const int *positions, int count) {
+    int var_count = pla_function_get_var_count(this);
+    int new_var_count = var_count;
+    int* son_at = malloc(var_count * sizeof(int));
+    for (int position = 0; position < var_count; position++) {
+        son_at[position] = -1;
+    }
+    for (int k = 0; k < count; k++) {
+        son_at[positions[k]] = k;
+        new_var_count += pla_function_get_var_count(others[k]) - 1;
+    }
+
+    bdd_manager manager;
+    bdd_manager_init(&manager);
+
+    int* var_map = malloc((var_count > 0 ? var_count : 1) * sizeof(int));
+    int* son_offsets = malloc(count * sizeof(int));
+    int next_var = 0;
+    for (int position = 0; position < var_count; position++) {
+        int k = son_at[position];
+        if (k >= 0) {
+            son_offsets[k] = next_var;
+            next_var += pla_function_get_var_count(others[k]);
+        } else {
+            next_var++;
+        }
+    }
+
+    int placeholder = new_var_count;
+    next_var = 0;
+    for (int position = 0; position < var_count; position++) {
+        int k = son_at[position];
+        if (k >= 0) {
+            var_map[position] = placeholder++;
+            next_var += pla_function_get_var_count(others[k]);
+        } else {
+            var_map[position] = next_var++;
+        }
+    }
+    int result = bdd_manager_from_pla(&manager, this, var_map);
+
+    placeholder = new_var_count;
+    for (int position = 0; position < var_count; position++) {
+        int k = son_at[position];
+        if (k < 0) {
+            continue;
+        }
+        int son_var_count = pla_function_get_var_count(others[k]);
+        int* son_map = malloc((son_var_count > 0 ? son_var_count : 1) * sizeof(int));
+        for (int i = 0; i < son_var_count; i++) {
+            son_map[i] = son_offsets[k] + i;
+        }
+        int son = bdd_manager_from_pla(&manager, others[k], son_map);
+        free(son_map);
+        result = bdd_manager_compose(&manager, result, placeholder++, son);
+    }
+
+    pla_function new_pla;
+    _Bool converted = bdd_manager_to_pla(&manager, result, new_var_count, &new_pla);
+    if (converted) {
+        pla_function_move(this, &new_pla);
+    }
+
+    bdd_manager_destroy(&manager);
+    free(son_offsets);
+    free(var_map);
+    free(son_at);
+    return converted;
+}
@@ -0,0 +1,162 @@
+#ifndef BDD_H
+#define BDD_H
+#include <stddef.h>
+#include <stdint.h>
+#include "pla_function.h"
+
+/**
+ * @file bdd.h
+ * @brief Reduced ordered binary decision diagrams.
+ *
+ * Nodes live in one array of the manager and are referenced by index,
+ * BDD_FALSE and BDD_TRUE are the terminals. The unique table keeps every
+ * node reduced and shared, the computed table caches results of ITE and
+ * restrict. Variables are ordered by their index.
+ */
+#define BDD_FALSE 0
+#define BDD_TRUE 1
+#define BDD_TERMINAL_VAR INT32_MAX
+
+/**
+ * @brief Maximum number of cubes bdd_manager_to_pla writes, more paths make the conversion fail.
+ */
+#define BDD_MAX_PLA_LINES ((size_t)1 << 24)
+
+/**
+ * @brief Node of a BDD.
+ *
+ * Fields:
+ * - var_: Variable tested by the node, BDD_TERMINAL_VAR for terminals.
+ * - low_: Node taken when the variable is 0.
+ * - high_: Node taken when the variable is 1.
+ */
+typedef struct bdd_node {
+    int var_;
+    int low_;
+    int high_;
+} bdd_node;
+
+/**
+ * @brief Entry of the computed table.
+ *
+ * Fields:
+ * - operation_: Operation the entry belongs to, 0 for an empty entry.
+ * - f_, g_, h_: Operands.
+ * - result_: Result of the operation.
+ */
+typedef struct bdd_cache_entry {
+    int operation_;
+    int f_;
+    int g_;
+    int h_;
+    int result_;
+} bdd_cache_entry;
+
+/**
+ * @brief Owns the nodes and tables of BDDs over a set of variables.
+ *
+ * Fields:
+ * - nodes_: Array of all nodes, the first two are the terminals.
+ * - node_count_: Number of used nodes.
+ * - node_capacity_: Allocated number of nodes.
+ * - unique_: Open addressing table of node indices, -1 for an empty slot.
+ * - unique_mask_: Size of the unique table minus one.
+ * - cache_: Direct mapped computed table.
+ * - cache_mask_: Size of the computed table minus one.
+ */
+typedef struct bdd_manager {
+    bdd_node* nodes_;
+    int node_count_;
+    int node_capacity_;
+    int* unique_;
+    int unique_mask_;
+    bdd_cache_entry* cache_;
+    int cache_mask_;
+} bdd_manager;
+
+/**
+ * @brief Initializes a BDD manager holding only the terminals.
+ * @param this Pointer to the BDD manager.
+ */
+void bdd_manager_init(bdd_manager* this);
+
+/**
+ * @brief Destroys a BDD manager and all its nodes.
+ * @param this Pointer to the BDD manager.
+ */
+void bdd_manager_destroy(bdd_manager* this);
+
+/**
+ * @brief Gets the reduced node testing a variable, creating it if needed.
+ * @param this Pointer to the BDD manager.
+ * @param var Variable tested by the node.
+ * @param low Node for the variable being 0.
+ * @param high Node for the variable being 1.
+ * @return Index of the node.
+ */
+int bdd_manager_make_node(bdd_manager* this, int var, int low, int high);
+
+/**
+ * @brief Computes if-then-else of three BDDs.
+ * @param this Pointer to the BDD manager.
+ * @param f Condition.
+ * @param g Result where f is 1.
+ * @param h Result where f is 0.
+ * @return Index of the resulting node.
+ */
+int bdd_manager_ite(bdd_manager* this, int f, int g, int h);
+
+/**
+ * @brief Fixes the value of a variable in a BDD.
+ * @param this Pointer to the BDD manager.
+ * @param f BDD to restrict.
+ * @param var Variable to fix.
+ * @param value Value of the variable (0 or 1).
+ * @return Index of the resulting node.
+ */
+int bdd_manager_restrict(bdd_manager* this, int f, int var, int value);
+
+/**
+ * @brief Substitutes a BDD for a variable of another BDD.
+ * @param this Pointer to the BDD manager.
+ * @param f BDD to substitute into.
+ * @param var Variable to replace.
+ * @param g BDD replacing the variable.
+ * @return Index of the resulting node.
+ */
+int bdd_manager_compose(bdd_manager* this, int f, int var, int g);
+
+/**
+ * @brief Builds the BDD of the on-set of a PLA function.
+ * @param this Pointer to the BDD manager.
+ * @param function Pointer to the PLA function.
+ * @param var_map Distinct variable of the BDD for every variable of the PLA.
+ * @return Index of the resulting node.
+ */
+int bdd_manager_from_pla(bdd_manager* this, pla_function* function, const int* var_map);
+
+/**
+ * @brief Writes the paths of a BDD leading to BDD_TRUE as '1' cubes of a PLA function.
+ * @param this Pointer to the BDD manager.
+ * @param f BDD to convert.
+ * @param var_count Number of variables of the PLA function.
+ * @param result Pointer to the uninitialized PLA function.
+ * @return true if the paths were written, false if there are more than BDD_MAX_PLA_LINES of them and result stays uninitialized.
+ */
+_Bool bdd_manager_to_pla(bdd_manager* this, int f, int var_count, pla_function* result);
+
+/**
+ * @brief Inputs additional variables from several PLA functions by BDD composition.
+ *
+ * Computes the same on-set as pla_function_input_variables_batch with
+ * on_set_only, but builds the result as a BDD, so its size does not depend
+ * on the products of the cube counts. The result holds the on-set only.
+ * @param this Pointer to the target PLA function.
+ * @param others Array of pointers to the source PLA functions.
+ * @param positions Array of positions to insert the variables of each source.
+ * @param count Number of sources.
+ * @return true if the function was replaced, false if the result has too many cubes and the function is unchanged.
+ */
+_Bool bdd_input_variables(pla_function* this, pla_function** others, const int* positions, int count);
+
+#endif //BDD_H
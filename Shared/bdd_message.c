@@ -1,4 +1,6 @@
 #include "bdd_message.h"
+#include "lz_codec.h"
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -104,7 +106,106 @@ void bdd_message_allocate_buffer(bdd_message *this, size_t buffer_size) {
     }
     this->serialized_buffer_size_ = buffer_size;
     this->serialized_buffer_ = malloc(this->serialized_buffer_size_);
-    memset(this->serialized_buffer_, 0, this->serialized_buffer_size_);
+}
+
+/**
+ * @brief Allocates the serialized buffer and writes the message header into it.
+ * @return Pointer to the place of the payload in the buffer.
+ */
+static char* bdd_message_write_header(bdd_message* this, size_t payload_size) {
+    bdd_message_allocate_buffer(this, BDD_MESSAGE_HEADER_SIZE + payload_size);
+
+    char* header = this->serialized_buffer_;
+    memset(header, 0, BDD_MESSAGE_HEADER_SIZE);
+    memcpy(header, &this->client_id_, sizeof(this->client_id_));
+    memcpy(header + BDD_MESSAGE_HEADER_SIZE - sizeof(payload_size), &payload_size, sizeof(payload_size));
+
+    return header + BDD_MESSAGE_HEADER_SIZE;
+}
+
+/**
+ * @brief Reads the message header from the serialized buffer.
+ * @return Pointer to the payload in the buffer, or NULL if the buffer is too short.
+ */
+static char* bdd_message_read_header(bdd_message* this, size_t* payload_size) {
+    if (!this->serialized_buffer_ || this->serialized_buffer_size_ < BDD_MESSAGE_HEADER_SIZE ||
+        !bdd_message_decompress(this)) {
+        return NULL;
+    }
+
+    char* header = this->serialized_buffer_;
+    memcpy(&this->client_id_, header, sizeof(this->client_id_));
+    memcpy(payload_size, header + BDD_MESSAGE_HEADER_SIZE - sizeof(*payload_size), sizeof(*payload_size));
+
+    if (this->serialized_buffer_size_ - BDD_MESSAGE_HEADER_SIZE < *payload_size) {
+        return NULL;
+    }
+    return header + BDD_MESSAGE_HEADER_SIZE;
+}
+
+_Bool bdd_message_compress(bdd_message* this) {
+    char* header = this->serialized_buffer_;
+    if (!header || this->serialized_buffer_size_ < BDD_MESSAGE_HEADER_SIZE + BDD_MESSAGE_COMPRESS_MIN_SIZE ||
+        header[sizeof(this->client_id_)] != BDD_MESSAGE_ENCODING_RAW) {
+        return false;
+    }
+
+    size_t raw_size = this->serialized_buffer_size_ - BDD_MESSAGE_HEADER_SIZE;
+    // The compressed payload has to be smaller than the raw one, including the raw size in front of it.
+    size_t capacity = raw_size - sizeof(raw_size) - 1;
+    char* buffer = malloc(BDD_MESSAGE_HEADER_SIZE + sizeof(raw_size) + capacity);
+    if (!buffer) {
+        return false;
+    }
+    size_t compressed_size = lz_codec_compress(header + BDD_MESSAGE_HEADER_SIZE, raw_size,
+                                               buffer + BDD_MESSAGE_HEADER_SIZE + sizeof(raw_size), capacity);
+    if (compressed_size == 0) {
+        free(buffer);
+        return false;
+    }
+
+    size_t payload_size = sizeof(raw_size) + compressed_size;
+    memcpy(buffer, header, BDD_MESSAGE_HEADER_SIZE);
+    buffer[sizeof(this->client_id_)] = BDD_MESSAGE_ENCODING_LZ;
+    memcpy(buffer + BDD_MESSAGE_HEADER_SIZE - sizeof(payload_size), &payload_size, sizeof(payload_size));
+    memcpy(buffer + BDD_MESSAGE_HEADER_SIZE, &raw_size, sizeof(raw_size));
+
+    free(this->serialized_buffer_);
+    this->serialized_buffer_ = buffer;
+    this->serialized_buffer_size_ = BDD_MESSAGE_HEADER_SIZE + payload_size;
+    return true;
+}
+
+_Bool bdd_message_decompress(bdd_message* this) {
+    char* header = this->serialized_buffer_;
+    if (!header || this->serialized_buffer_size_ < BDD_MESSAGE_HEADER_SIZE) {
+        return false;
+    }
+    if (header[sizeof(this->client_id_)] == BDD_MESSAGE_ENCODING_RAW) {
+        return true;
+    }
+
+    size_t raw_size;
+    size_t payload_size = this->serialized_buffer_size_ - BDD_MESSAGE_HEADER_SIZE;
+    if (header[sizeof(this->client_id_)] != BDD_MESSAGE_ENCODING_LZ || payload_size < sizeof(raw_size)) {
+        return false;
+    }
+    memcpy(&raw_size, header + BDD_MESSAGE_HEADER_SIZE, sizeof(raw_size));
+
+    char* buffer = malloc(BDD_MESSAGE_HEADER_SIZE + raw_size);
+    if (!buffer || !lz_codec_decompress(header + BDD_MESSAGE_HEADER_SIZE + sizeof(raw_size), payload_size - sizeof(raw_size),
+                                        buffer + BDD_MESSAGE_HEADER_SIZE, raw_size)) {
+        free(buffer);
+        return false;
+    }
+    memcpy(buffer, header, BDD_MESSAGE_HEADER_SIZE);
+    buffer[sizeof(this->client_id_)] = BDD_MESSAGE_ENCODING_RAW;
+    memcpy(buffer + BDD_MESSAGE_HEADER_SIZE - sizeof(raw_size), &raw_size, sizeof(raw_size));
+
+    free(this->serialized_buffer_);
+    this->serialized_buffer_ = buffer;
+    this->serialized_buffer_size_ = BDD_MESSAGE_HEADER_SIZE + raw_size;
+    return true;
 }
 
 size_t bdd_message_serialize(
@@ -118,42 +219,36 @@ size_t bdd_message_serialize(
         return 0;
     }
 
-    size_t total_size = sizeof(this->client_id_) + sizeof(serialized_payload_size) + serialized_payload_size;
-
-    bdd_message_allocate_buffer(this, total_size);
-
-    size_t offset = 0;
-
-    memcpy((char*)this->serialized_buffer_ + offset, &this->client_id_, sizeof(this->client_id_));
-    offset += sizeof(this->client_id_);
-
-    memcpy((char*)this->serialized_buffer_ + offset, &serialized_payload_size, sizeof(serialized_payload_size));
-    offset += sizeof(serialized_payload_size);
-
-    memcpy((char*)this->serialized_buffer_ + offset, serialized_payload, serialized_payload_size);
+    char* payload = bdd_message_write_header(this, serialized_payload_size);
+    memcpy(payload, serialized_payload, serialized_payload_size);
 
     free(serialized_payload);
-    return total_size;
+    return this->serialized_buffer_size_;
 }
 
-size_t bdd_message_deserialize(
+size_t bdd_message_serialize_direct(
     bdd_message* this,
-    void* (*deserialize_payload)(const void* serialized_payload, size_t size)
+    size_t (*write_payload)(void* payload, char* buffer)
 ) {
-    size_t offset = 0;
+    size_t serialized_payload_size = write_payload(this->payload_, NULL);
 
-    if (!this->serialized_buffer_ || this->serialized_buffer_size_ < sizeof(this->client_id_) + sizeof(this->payload_size_)) {
+    if (serialized_payload_size == 0) {
         return 0;
     }
 
-    memcpy(&this->client_id_, (char*)this->serialized_buffer_ + offset, sizeof(this->client_id_));
-    offset += sizeof(this->client_id_);
+    write_payload(this->payload_, bdd_message_write_header(this, serialized_payload_size));
+
+    return this->serialized_buffer_size_;
+}
 
+size_t bdd_message_deserialize(
+    bdd_message* this,
+    void* (*deserialize_payload)(const void* serialized_payload, size_t size)
+) {
     size_t payload_size;
-    memcpy(&payload_size, (char*)this->serialized_buffer_ + offset, sizeof(payload_size));
-    offset += sizeof(payload_size);
+    char* serialized_payload = bdd_message_read_header(this, &payload_size);
 
-    if (this->serialized_buffer_size_ < offset + payload_size) {
+    if (!serialized_payload) {
         return 0;
     }
 
@@ -162,7 +257,7 @@ size_t bdd_message_deserialize(
     }
 
     if (deserialize_payload) {
-        this->payload_ = deserialize_payload((char*)this->serialized_buffer_ + offset, payload_size);
+        this->payload_ = deserialize_payload(serialized_payload, payload_size);
         if (!this->payload_) {
             return 0;
         }
@@ -171,13 +266,40 @@ size_t bdd_message_deserialize(
         if (!this->payload_) {
             return 0;
         }
-        memcpy(this->payload_, (char*)this->serialized_buffer_ + offset, payload_size);
+        memcpy(this->payload_, serialized_payload, payload_size);
     }
 
     this->payload_size_ = payload_size;
-    offset += payload_size;
 
-    return offset;
+    return BDD_MESSAGE_HEADER_SIZE + payload_size;
+}
+
+size_t bdd_message_deserialize_in_place(
+    bdd_message* this,
+    void* (*deserialize_payload)(void* buffer, void* serialized_payload, size_t size)
+) {
+    size_t payload_size;
+    char* serialized_payload = bdd_message_read_header(this, &payload_size);
+
+    if (!serialized_payload) {
+        return 0;
+    }
+
+    if (this->payload_) {
+        free(this->payload_);
+    }
+
+    this->payload_ = deserialize_payload(this->serialized_buffer_, serialized_payload, payload_size);
+    if (!this->payload_) {
+        return 0;
+    }
+    this->payload_size_ = payload_size;
+
+    // The payload owns the buffer now.
+    this->serialized_buffer_ = NULL;
+    this->serialized_buffer_size_ = 0;
+
+    return BDD_MESSAGE_HEADER_SIZE + payload_size;
 }
 
 
@@ -2,6 +2,38 @@
 #define BDD_MESSAGE_H
 #include <stddef.h>
 
+/**
+ * @brief Client ID of a message reporting a finished task whose merged module stays on the client.
+ */
+#define BDD_MESSAGE_TASK_DONE -3
+
+/**
+ * @brief Client ID of a message uploading the merged module of a finished task to the server.
+ */
+#define BDD_MESSAGE_TASK_UPLOAD -4
+
+/**
+ * @brief Size of the serialized message header.
+ *
+ * The header holds the client ID at the start, the encoding of the payload
+ * right after it and the payload size in its last 8 bytes, the rest is zero.
+ * Payloads start 8-byte aligned in the buffer.
+ */
+#define BDD_MESSAGE_HEADER_SIZE 16
+
+/**
+ * @brief Encodings of a serialized payload.
+ * - BDD_MESSAGE_ENCODING_RAW: payload as written by its serializer.
+ * - BDD_MESSAGE_ENCODING_LZ: size of the raw payload followed by its lz_codec block.
+ */
+#define BDD_MESSAGE_ENCODING_RAW 0
+#define BDD_MESSAGE_ENCODING_LZ 1
+
+/**
+ * @brief Smallest payload bdd_message_compress tries to compress.
+ */
+#define BDD_MESSAGE_COMPRESS_MIN_SIZE 512
+
 /**
  * @brief Represents a message structure for communication between a client and server.
  *
@@ -118,6 +150,16 @@ void bdd_message_allocate_buffer(bdd_message* this, size_t buffer_size);
  */
 size_t bdd_message_serialize(bdd_message* this, size_t (*serialize_payload)(void* payload, void** serialized_payload));
 
+/**
+ * @brief Serializes the message with the payload written directly into the message buffer.
+ *
+ * The size of the payload is computed first, so the payload is copied only once.
+ * @param this Pointer to the bdd_message instance.
+ * @param write_payload Function writing the payload, returning its size and writing nothing for a NULL buffer.
+ * @return Total size of the serialized message.
+ */
+size_t bdd_message_serialize_direct(bdd_message* this, size_t (*write_payload)(void* payload, char* buffer));
+
 /**
  * @brief Deserializes a message from a buffer.
  * @param this Pointer to the bdd_message instance.
@@ -126,4 +168,32 @@ size_t bdd_message_serialize(bdd_message* this, size_t (*serialize_payload)(void
  */
 size_t bdd_message_deserialize(bdd_message* this, void* (*deserialize_payload)(const void* serialized_payload, size_t size));
 
+/**
+ * @brief Deserializes a message whose payload keeps the serialized buffer as its storage.
+ *
+ * On success the payload takes ownership of the buffer and the message no
+ * longer references it.
+ * @param this Pointer to the bdd_message instance.
+ * @param deserialize_payload Function deserializing the payload, taking ownership of the buffer unless it returns NULL.
+ * @return Total size of the deserialized message.
+ */
+size_t bdd_message_deserialize_in_place(bdd_message* this, void* (*deserialize_payload)(void* buffer, void* serialized_payload, size_t size));
+
+/**
+ * @brief Compresses the payload of the serialized message with lz_codec.
+ *
+ * The buffer is only replaced if the compressed message is smaller.
+ * Deserialization decompresses the payload on its own.
+ * @param this Pointer to the serialized bdd_message instance.
+ * @return true if the payload was compressed, false if it stays raw.
+ */
+_Bool bdd_message_compress(bdd_message* this);
+
+/**
+ * @brief Replaces a compressed serialized buffer with the raw one.
+ * @param this Pointer to the serialized bdd_message instance.
+ * @return true if the buffer is raw now, false if the compressed payload is invalid.
+ */
+_Bool bdd_message_decompress(bdd_message* this);
+
 #endif //BDD_MESSAGE_H
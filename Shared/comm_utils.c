@@ -95,7 +95,8 @@ void print_buffer(const void* buffer, size_t size) {
 ssize_t send_all(int socket, const void* buffer, size_t length) {
     size_t total_sent = 0;
     while (total_sent < length) {
-        ssize_t sent = send(socket, (const char*)buffer + total_sent, length - total_sent, 0);
+        // A peer that closed the connection fails the send instead of raising SIGPIPE.
+        ssize_t sent = send(socket, (const char*)buffer + total_sent, length - total_sent, MSG_NOSIGNAL);
         if (sent <= 0) {
             return sent;
         }
@@ -45,7 +45,7 @@ void print_buffer(const void* buffer, size_t size);
  * @param socket The socket descriptor.
  * @param buffer Pointer to the buffer to send.
  * @param length Length of the buffer.
- * @return Total bytes sent, or -1 on error.
+ * @return Total bytes sent, or -1 on error, including a connection closed by the peer.
  */
 ssize_t send_all(int socket, const void* buffer, size_t length);
 
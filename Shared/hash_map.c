@@ -0,0 +1,73 @@
+#include "hash_map.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HASH_MAP_DEFAULT_CAPACITY 16
+
+static uint64_t hash_map_hash(const char *key) {
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for (; *key; key++) {
+        hash ^= (unsigned char)*key;
+        hash *= UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+static hash_map_entry* hash_map_find_slot(hash_map_entry *entries, int capacity, const char *key) {
+    int index = (int)(hash_map_hash(key) & (uint64_t)(capacity - 1));
+    while (entries[index].key_ && strcmp(entries[index].key_, key) != 0) {
+        index = (index + 1) & (capacity - 1);
+    }
+    return entries + index;
+}
+
+static void hash_map_resize(hash_map *this, int new_capacity) {
+    hash_map_entry* entries = calloc(new_capacity, sizeof(hash_map_entry));
+    for (int i = 0; i < this->capacity_; i++) {
+        if (this->entries_[i].key_) {
+            *hash_map_find_slot(entries, new_capacity, this->entries_[i].key_) = this->entries_[i];
+        }
+    }
+    free(this->entries_);
+    this->entries_ = entries;
+    this->capacity_ = new_capacity;
+}
+
+void hash_map_init(hash_map *this) {
+    this->capacity_ = HASH_MAP_DEFAULT_CAPACITY;
+    this->size_ = 0;
+    this->entries_ = calloc(this->capacity_, sizeof(hash_map_entry));
+}
+
+void hash_map_destroy(hash_map *this) {
+    free(this->entries_);
+    this->entries_ = NULL;
+    this->capacity_ = 0;
+    this->size_ = 0;
+}
+
+void hash_map_clear(hash_map *this) {
+    memset(this->entries_, 0, this->capacity_ * sizeof(hash_map_entry));
+    this->size_ = 0;
+}
+
+int hash_map_get_size(const hash_map *this) {
+    return this->size_;
+}
+
+void hash_map_put(hash_map *this, const char *key, void *value) {
+    if (2 * (this->size_ + 1) > this->capacity_) {
+        hash_map_resize(this, 2 * this->capacity_);
+    }
+    hash_map_entry* slot = hash_map_find_slot(this->entries_, this->capacity_, key);
+    if (!slot->key_) {
+        slot->key_ = key;
+        this->size_++;
+    }
+    slot->value_ = value;
+}
+
+void* hash_map_get(const hash_map *this, const char *key) {
+    return hash_map_find_slot(this->entries_, this->capacity_, key)->value_;
+}
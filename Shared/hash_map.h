@@ -0,0 +1,91 @@
+#ifndef HASH_MAP_H
+#define HASH_MAP_H
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file hash_map.h
+ * @brief Hash map from strings to pointers.
+ *
+ * Open addressing with linear probing, the table doubles when it gets half
+ * full. Keys are not copied, they have to stay valid while they are in the map
+ * (module names are owned by their modules).
+ *
+ * Usage:
+ * - Initialize the map with `hash_map_init`.
+ * - Insert values with `hash_map_put`, look them up with `hash_map_get`.
+ * - Destroy the map with `hash_map_destroy`, values are not freed.
+ */
+/**
+ * @brief Slot of the hash map table.
+ *
+ * Fields:
+ * - key_: Key of the entry, borrowed from the caller, or NULL for an empty slot.
+ * - value_: Value stored under the key.
+ */
+typedef struct hash_map_entry {
+    const char* key_;
+    void* value_;
+} hash_map_entry;
+
+/**
+ * @brief Represents a hash map from strings to pointers.
+ *
+ * Fields:
+ * - entries_: Table of capacity_ slots.
+ * - capacity_: Number of slots, a power of two.
+ * - size_: Number of occupied slots.
+ */
+typedef struct hash_map {
+    hash_map_entry* entries_;
+    int capacity_;
+    int size_;
+} hash_map;
+
+/**
+ * @brief Initializes an empty hash map.
+ * @param this Pointer to the map.
+ */
+void hash_map_init(hash_map *this);
+
+/**
+ * @brief Destroys a hash map.
+ *
+ * Neither the keys nor the values are freed, they belong to the caller.
+ * @param this Pointer to the map.
+ */
+void hash_map_destroy(hash_map *this);
+
+/**
+ * @brief Removes all entries and keeps the table allocated.
+ *
+ * Neither the keys nor the values are freed, so the caller may free them
+ * right after, as long as the keys are not looked up again.
+ * @param this Pointer to the map.
+ */
+void hash_map_clear(hash_map *this);
+
+/**
+ * @brief Gets the number of entries.
+ * @param this Pointer to the map.
+ * @return Number of keys stored in the map.
+ */
+int hash_map_get_size(const hash_map *this);
+
+/**
+ * @brief Inserts a value or replaces the value stored under the key.
+ * @param this Pointer to the map.
+ * @param key Key, not copied, it has to stay valid and unchanged while it is in the map.
+ * @param value Value to store.
+ */
+void hash_map_put(hash_map *this, const char *key, void *value);
+
+/**
+ * @brief Looks up the value stored under a key.
+ * @param this Pointer to the map.
+ * @param key Key to look up.
+ * @return Stored value, or NULL if the key is not in the map.
+ */
+void* hash_map_get(const hash_map *this, const char *key);
+
+#endif //HASH_MAP_H
@@ -0,0 +1,162 @@
+#include "lz_codec.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+static uint32_t lz_codec_read32(const unsigned char* bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static uint32_t lz_codec_hash(uint32_t value) {
+    return (value * UINT32_C(2654435761)) >> (32 - LZ_CODEC_HASH_BITS);
+}
+
+static unsigned char* lz_codec_write_length(unsigned char* out, const unsigned char* end, size_t length) {
+    for (; length >= 255; length -= 255) {
+        if (out >= end) {
+            return NULL;
+        }
+        *out++ = 255;
+    }
+    if (out >= end) {
+        return NULL;
+    }
+    *out++ = (unsigned char)length;
+    return out;
+}
+
+/**
+ * @brief Writes one sequence, a match length of 0 marks the last sequence without a match.
+ * @return Position after the sequence, or NULL if it does not fit.
+ */
+static unsigned char* lz_codec_write_sequence(unsigned char* out, const unsigned char* end, const unsigned char* literals,
+                                              size_t literal_count, size_t offset, size_t match_length) {
+    if (out >= end) {
+        return NULL;
+    }
+    size_t match_code = match_length > 0 ? match_length - LZ_CODEC_MIN_MATCH : 0;
+    unsigned char* token = out++;
+    *token = (unsigned char)((literal_count < 15 ? literal_count : 15) << 4 | (match_code < 15 ? match_code : 15));
+
+    if (literal_count >= 15 && !(out = lz_codec_write_length(out, end, literal_count - 15))) {
+        return NULL;
+    }
+    if ((size_t)(end - out) < literal_count) {
+        return NULL;
+    }
+    memcpy(out, literals, literal_count);
+    out += literal_count;
+
+    if (match_length == 0) {
+        return out;
+    }
+    if (end - out < 2) {
+        return NULL;
+    }
+    *out++ = (unsigned char)(offset & 0xFF);
+    *out++ = (unsigned char)(offset >> 8);
+    if (match_code >= 15 && !(out = lz_codec_write_length(out, end, match_code - 15))) {
+        return NULL;
+    }
+    return out;
+}
+
+size_t lz_codec_compress(const void *source, size_t size, void *destination, size_t capacity) {
+    const unsigned char* in = source;
+    unsigned char* out = destination;
+    const unsigned char* out_end = out + capacity;
+    // Positions are stored plus one, 0 marks an empty slot.
+    size_t table[1 << LZ_CODEC_HASH_BITS] = {0};
+
+    size_t anchor = 0;
+    size_t position = 0;
+    size_t limit = size > LZ_CODEC_MIN_MATCH ? size - LZ_CODEC_MIN_MATCH : 0;
+    while (position < limit) {
+        uint32_t sequence = lz_codec_read32(in + position);
+        uint32_t hash = lz_codec_hash(sequence);
+        size_t candidate = table[hash];
+        table[hash] = position + 1;
+        if (candidate == 0 || position - (candidate - 1) > LZ_CODEC_MAX_OFFSET ||
+            lz_codec_read32(in + candidate - 1) != sequence) {
+            position++;
+            continue;
+        }
+        candidate--;
+
+        size_t match_length = LZ_CODEC_MIN_MATCH;
+        while (position + match_length < size && in[candidate + match_length] == in[position + match_length]) {
+            match_length++;
+        }
+
+        out = lz_codec_write_sequence(out, out_end, in + anchor, position - anchor, position - candidate, match_length);
+        if (!out) {
+            return 0;
+        }
+        position += match_length;
+        anchor = position;
+    }
+
+    out = lz_codec_write_sequence(out, out_end, in + anchor, size - anchor, 0, 0);
+    return out ? (size_t)(out - (unsigned char*)destination) : 0;
+}
+
+static _Bool lz_codec_read_length(const unsigned char** in, const unsigned char* end, size_t* length) {
+    unsigned char byte;
+    do {
+        if (*in >= end) {
+            return false;
+        }
+        byte = *(*in)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+_Bool lz_codec_decompress(const void *source, size_t size, void *destination, size_t destination_size) {
+    const unsigned char* in = source;
+    const unsigned char* in_end = in + size;
+    unsigned char* out = destination;
+    unsigned char* out_end = out + destination_size;
+
+    while (in < in_end) {
+        unsigned char token = *in++;
+
+        size_t literal_count = token >> 4;
+        if (literal_count == 15 && !lz_codec_read_length(&in, in_end, &literal_count)) {
+            return false;
+        }
+        if ((size_t)(in_end - in) < literal_count || (size_t)(out_end - out) < literal_count) {
+            return false;
+        }
+        memcpy(out, in, literal_count);
+        in += literal_count;
+        out += literal_count;
+
+        if (in == in_end) {
+            break;
+        }
+        if (in_end - in < 2) {
+            return false;
+        }
+        size_t offset = in[0] | (size_t)in[1] << 8;
+        in += 2;
+        size_t match_length = token & 0x0F;
+        if (match_length == 15 && !lz_codec_read_length(&in, in_end, &match_length)) {
+            return false;
+        }
+        match_length += LZ_CODEC_MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(out - (unsigned char*)destination) || (size_t)(out_end - out) < match_length) {
+            return false;
+        }
+        // Matches may overlap the bytes they produce, so they are copied byte by byte.
+        const unsigned char* match = out - offset;
+        for (size_t i = 0; i < match_length; i++) {
+            out[i] = match[i];
+        }
+        out += match_length;
+    }
+
+    return out == out_end;
+}
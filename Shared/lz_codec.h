@@ -0,0 +1,39 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+#include <stddef.h>
+
+/**
+ * @brief Fast byte-oriented LZ77 codec in the style of LZ4 block compression.
+ *
+ * The output is a series of sequences. Each starts with a token byte: the
+ * high nibble is the number of literals and the low nibble is the match
+ * length minus LZ_CODEC_MIN_MATCH. A nibble of 15 continues in the following
+ * bytes, each adding up to 255. The literals follow, then a 2-byte
+ * little-endian offset of the match and its extra length bytes. The last
+ * sequence has literals only.
+ */
+#define LZ_CODEC_MIN_MATCH 4
+#define LZ_CODEC_MAX_OFFSET 65535
+#define LZ_CODEC_HASH_BITS 12
+
+/**
+ * @brief Compresses a block of bytes.
+ * @param source Bytes to compress.
+ * @param size Number of bytes in source.
+ * @param destination Output buffer.
+ * @param capacity Size of the output buffer.
+ * @return Size of the compressed block, or 0 if it does not fit into capacity.
+ */
+size_t lz_codec_compress(const void* source, size_t size, void* destination, size_t capacity);
+
+/**
+ * @brief Decompresses a block created by lz_codec_compress.
+ * @param source Compressed block.
+ * @param size Size of the compressed block.
+ * @param destination Output buffer.
+ * @param destination_size Exact size of the decompressed data.
+ * @return true if the block was valid and decompressed to destination_size bytes, false otherwise.
+ */
+_Bool lz_codec_decompress(const void* source, size_t size, void* destination, size_t destination_size);
+
+#endif //LZ_CODEC_H
@@ -1,16 +1,15 @@
 #include "module.h"
+#include "bdd.h"
 
 void son_name_and_pos_init(son_name_and_pos *this, char *son_name, int son_position) {
-    memset(this->son_name_, 0, sizeof(this->son_name_));
-    size_t null_index = strlen(son_name) < sizeof(this->son_name_) ? strlen(son_name) : sizeof(this->son_name_) - 1;
-    strncpy(this->son_name_, son_name, null_index);
-    this->son_name_[null_index] = '\0';
+    this->son_name_ = strdup(son_name);
     this->son_position_ = son_position;
 }
 
 void son_name_and_pos_destroy(const void *item) {
     son_name_and_pos* this = (son_name_and_pos*)item;
-    this->son_name_[0] = '\0';
+    free(this->son_name_);
+    this->son_name_ = NULL;
     this->son_position_ = 0;
 }
 
@@ -19,9 +18,7 @@ bool son_name_and_pos_compare_name(const void *item, void *property) {
 }
 
 size_t son_name_and_pos_serialize(void *item, void **serialized_payload) {
-    son_name_and_pos* son = (son_name_and_pos*)item;
-
-    size_t serialized_size = sizeof(son->son_name_) + sizeof(son->son_position_);
+    size_t serialized_size = son_name_and_pos_write(item, NULL);
 
     *serialized_payload = malloc(serialized_size);
     if (!*serialized_payload) {
@@ -29,17 +26,24 @@ size_t son_name_and_pos_serialize(void *item, void **serialized_payload) {
         return 0;
     }
 
-    char* cursor = *serialized_payload;
-    memcpy(cursor, son->son_name_, sizeof(son->son_name_));
-    cursor += sizeof(son->son_name_);
-    memcpy(cursor, &son->son_position_, sizeof(son->son_position_));
+    return son_name_and_pos_write(item, *serialized_payload);
+}
+
+size_t son_name_and_pos_write(void *item, char *buffer) {
+    son_name_and_pos* son = (son_name_and_pos*)item;
 
-    return serialized_size;
+    size_t name_size = strlen(son->son_name_) + 1;
+    if (buffer) {
+        memcpy(buffer, &son->son_position_, sizeof(son->son_position_));
+        memcpy(buffer + sizeof(son->son_position_), son->son_name_, name_size);
+    }
+
+    return sizeof(son->son_position_) + name_size;
 }
 
 void * son_name_and_pos_deserialize(const void *serialized_payload, size_t size) {
-    if (size != sizeof(son_name_and_pos)) {
-        fprintf(stderr, "Invalid serialized size for son_name_and_pos: expected %zu, got %zu\n", sizeof(son_name_and_pos), size);
+    if (size <= sizeof(int)) {
+        fprintf(stderr, "Invalid serialized size for son_name_and_pos: expected more than %zu, got %zu\n", sizeof(int), size);
         return NULL;
     }
 
@@ -50,13 +54,62 @@ void * son_name_and_pos_deserialize(const void *serialized_payload, size_t size)
     }
 
     const char* cursor = serialized_payload;
-    memcpy(son->son_name_, cursor, sizeof(son->son_name_));
-    cursor += sizeof(son->son_name_);
     memcpy(&son->son_position_, cursor, sizeof(son->son_position_));
+    cursor += sizeof(son->son_position_);
+    son->son_name_ = strndup(cursor, size - sizeof(son->son_position_));
 
     return son;
 }
 
+static int son_index_entry_comparator(const void *this, const void *other) {
+    return strcmp(((son_index_entry*)this)->son_name_, ((son_index_entry*)other)->son_name_);
+}
+
+void son_index_init(son_index *this) {
+    this->by_name_ = NULL;
+    this->shifts_ = NULL;
+    this->size_ = 0;
+}
+
+void son_index_destroy(son_index *this) {
+    free(this->by_name_);
+    free(this->shifts_);
+    son_index_init(this);
+}
+
+void son_index_build(son_index *this, array_list *son_map) {
+    son_index_destroy(this);
+    this->size_ = array_list_get_size(son_map);
+    this->by_name_ = malloc(this->size_ * sizeof(son_index_entry));
+    this->shifts_ = calloc(this->size_ + 1, sizeof(int));
+    for (int i = 0; i < this->size_; i++) {
+        son_name_and_pos son;
+        array_list_try_get(son_map, i, &son);
+        this->by_name_[i].son_name_ = son.son_name_;
+        this->by_name_[i].son_index_ = i;
+    }
+    qsort(this->by_name_, this->size_, sizeof(son_index_entry), son_index_entry_comparator);
+}
+
+int son_index_find(son_index *this, char *son_name) {
+    son_index_entry key = { son_name, -1 };
+    son_index_entry* found = bsearch(&key, this->by_name_, this->size_, sizeof(son_index_entry), son_index_entry_comparator);
+    return found ? found->son_index_ : -1;
+}
+
+int son_index_get_shift(son_index *this, int son_index) {
+    int shift = 0;
+    for (int i = son_index + 1; i > 0; i -= i & -i) {
+        shift += this->shifts_[i];
+    }
+    return shift;
+}
+
+void son_index_add_shift(son_index *this, int first_son_index, int shift) {
+    for (int i = first_son_index + 1; i <= this->size_; i += i & -i) {
+        this->shifts_[i] += shift;
+    }
+}
 
 void print_son_map(const void* item) {
     printf("\tSon name: %s", ((son_name_and_pos*)item)->son_name_);
@@ -70,9 +123,12 @@ void module_init(module *this, char *name) {
     this->priority_ = 0;
     this->parent_ = NULL;
     this->path_ = NULL;
+    this->output_column_ = 0;
     this->function_ = malloc(sizeof(pla_function));
+    this->mv_function_ = NULL;
     this->son_map_ = malloc(sizeof(array_list));
     array_list_init(this->son_map_, sizeof(son_name_and_pos));
+    son_index_init(&this->son_index_);
 }
 
 void module_destroy(module *this) {
@@ -80,9 +136,15 @@ void module_destroy(module *this) {
     array_list_destroy(this->son_map_);
     free(this->son_map_);
     this->son_map_ = NULL;
+    son_index_destroy(&this->son_index_);
     pla_function_destroy(this->function_);
     free(this->function_);
     this->function_ = NULL;
+    if (this->mv_function_) {
+        mv_function_destroy(this->mv_function_);
+        free(this->mv_function_);
+        this->mv_function_ = NULL;
+    }
     this->parent_ = NULL;
     free(this->name_);
     this->name_ = NULL;
@@ -100,14 +162,36 @@ pla_function * module_get_function(module *this) {
     return this->function_;
 }
 
+mv_function * module_get_mv_function(module *this) {
+    return this->mv_function_;
+}
+
+void module_set_multi_valued(module *this) {
+    if (!this->mv_function_) {
+        this->mv_function_ = malloc(sizeof(mv_function));
+        mv_function_init(this->mv_function_, 0, NULL, 0, 0);
+    }
+}
+
 module * module_get_parent(module *this) {
     return this->parent_;
 }
 
+static void module_update_son_index(module *this) {
+    if (!this->son_index_.shifts_ || this->son_index_.size_ != array_list_get_size(this->son_map_)) {
+        son_index_build(&this->son_index_, this->son_map_);
+    }
+}
+
 int module_get_son_position(module *this, char* son_name) {
-    son_name_and_pos son = { '\0', -1};
-    array_list_find_by_property(this->son_map_, &son, son_name_and_pos_compare_name, son_name);
-    return son.son_position_;
+    module_update_son_index(this);
+    int index = son_index_find(&this->son_index_, son_name);
+    if (index < 0) {
+        return -1;
+    }
+    son_name_and_pos son;
+    array_list_try_get(this->son_map_, index, &son);
+    return son.son_position_ + son_index_get_shift(&this->son_index_, index);
 }
 
 int module_get_priority(module *this) {
@@ -115,9 +199,19 @@ int module_get_priority(module *this) {
 }
 
 int module_get_var_count(module *this) {
+    if (this->mv_function_) {
+        return mv_function_get_var_count(this->mv_function_);
+    }
     return this->function_ ? this->function_->var_count_ : 0;
 }
 
+int module_get_num_lines(module *this) {
+    if (this->mv_function_) {
+        return mv_function_get_num_lines(this->mv_function_);
+    }
+    return this->function_ ? pla_function_get_num_lines(this->function_) : 0;
+}
+
 int module_get_assigned_client(module *this) {
     return this->assigned_client_;
 }
@@ -138,11 +232,23 @@ void module_set_parent(module* this, module *parent) {
     this->parent_ = parent;
 }
 
+char * module_get_path(module *this) {
+    return this->path_;
+}
+
+int module_get_output_column(module *this) {
+    return this->output_column_;
+}
+
 void module_set_path(module *this, char *path) {
     if (this->path_) { free(this->path_); }
     this->path_ = strdup(path);
 }
 
+void module_set_output_column(module *this, int output_column) {
+    this->output_column_ = output_column;
+}
+
 int module_priority_comparator(const void *this, const void *other) {
     return (*(module**)this)->priority_ - (*(module**)other)->priority_;
 }
@@ -170,31 +276,130 @@ void module_create_function(module *this, int var_count, int line_count) {
     pla_function_init(this->function_, var_count, line_count);
 }
 
+/**
+ * @brief Merges sons into their parent as multi-valued functions, one by one.
+ */
+static void module_merge_sons_mv(module *parent, module **sons, int count) {
+    if (!parent->mv_function_) {
+        parent->mv_function_ = malloc(sizeof(mv_function));
+        mv_function_from_pla(parent->mv_function_, parent->function_);
+        pla_function_destroy(parent->function_);
+        pla_function_init(parent->function_, 0, 0);
+    }
+
+    for (int i = 0; i < count; i++) {
+        int position = module_get_son_position(parent, module_get_name(sons[i]));
+        if (position < 0) {
+            continue;
+        }
+        mv_function converted;
+        mv_function* son_function = sons[i]->mv_function_;
+        if (!son_function) {
+            mv_function_from_pla(&converted, sons[i]->function_);
+            son_function = &converted;
+        }
+        if (mv_function_input_variables(parent->mv_function_, son_function, position)) {
+            module_adjust_positions(parent, module_get_name(sons[i]), mv_function_get_var_count(son_function));
+        } else {
+            fprintf(stderr, "Output domain of module %s does not match its variable in module %s.\n",
+                    module_get_name(sons[i]), module_get_name(parent));
+        }
+        if (son_function == &converted) {
+            mv_function_destroy(&converted);
+        }
+    }
+}
+
 void module_merge_modules(module *parent, module *son) {
+    if (parent->mv_function_ || son->mv_function_) {
+        module_merge_sons_mv(parent, &son, 1);
+        return;
+    }
     int position = module_get_son_position(parent, module_get_name(son));
-    if (position >= 0) {
-        pla_function_input_variables(module_get_function(parent), module_get_function(son), position);
+    if (position < 0) {
+        return;
+    }
+    if (pla_function_input_variables(module_get_function(parent), module_get_function(son), position)) {
         module_adjust_positions(parent, module_get_name(son), module_get_var_count(son));
+    } else {
+        fprintf(stderr, "Module %s would have too many cubes after merging module %s, it was not merged.\n",
+                module_get_name(parent), module_get_name(son));
     }
 }
 
+void module_merge_sons(module *parent, module **sons, int count, module_merge_mode mode) {
+    _Bool multi_valued = parent->mv_function_ != NULL;
+    for (int i = 0; i < count && !multi_valued; i++) {
+        multi_valued = sons[i]->mv_function_ != NULL;
+    }
+    if (multi_valued) {
+        module_merge_sons_mv(parent, sons, count);
+        return;
+    }
+
+    pla_function** functions = malloc(count * sizeof(pla_function*));
+    int* positions = malloc(count * sizeof(int));
+    module** merged = malloc(count * sizeof(module*));
+    int merged_count = 0;
+
+    for (int i = 0; i < count; i++) {
+        int position = module_get_son_position(parent, module_get_name(sons[i]));
+        if (position >= 0) {
+            functions[merged_count] = module_get_function(sons[i]);
+            positions[merged_count] = position;
+            merged[merged_count] = sons[i];
+            merged_count++;
+        }
+    }
+
+    if (merged_count > 0) {
+        _Bool merged_all = mode == MODULE_MERGE_BDD && bdd_input_variables(module_get_function(parent), functions, positions, merged_count);
+        if (!merged_all) {
+            merged_all = pla_function_input_variables_batch(module_get_function(parent), functions, positions, merged_count, mode != MODULE_MERGE_CUBES);
+        }
+        if (merged_all) {
+            for (int i = 0; i < merged_count; i++) {
+                module_adjust_positions(parent, module_get_name(merged[i]), module_get_var_count(merged[i]));
+            }
+        } else {
+            fprintf(stderr, "Module %s would have too many cubes after merging its sons, they were not merged.\n", module_get_name(parent));
+        }
+    }
+
+    free(merged);
+    free(positions);
+    free(functions);
+}
+
 void module_add_son_position(module *this, char *son_name, int son_position) {
+    module_apply_son_shifts(this);
     son_name_and_pos new_son;
     son_name_and_pos_init(&new_son, son_name, son_position);
     array_list_add(this->son_map_, &new_son);
 }
 
 void module_adjust_positions(module *this, char *added_son, int son_var_count) {
-    son_name_and_pos temp;
-    int index = array_list_find_by_property(this->son_map_, &temp, son_name_and_pos_compare_name, added_son);
+    module_update_son_index(this);
+    int index = son_index_find(&this->son_index_, added_son);
     if (index >= 0 && index < array_list_get_size(this->son_map_) - 1) {
-        for (int i = index + 1; i < array_list_get_size(this->son_map_); i++) {
+        son_index_add_shift(&this->son_index_, index + 1, son_var_count - 1);
+    }
+}
+
+void module_apply_son_shifts(module *this) {
+    if (!this->son_index_.shifts_ || this->son_index_.size_ != array_list_get_size(this->son_map_)) {
+        return;
+    }
+    for (int i = 0; i < this->son_index_.size_; i++) {
+        int shift = son_index_get_shift(&this->son_index_, i);
+        if (shift != 0) {
             son_name_and_pos son;
             array_list_try_get(this->son_map_, i, &son);
-            son.son_position_ += son_var_count - 1;
+            son.son_position_ += shift;
             array_list_set(this->son_map_, i, &son);
         }
     }
+    son_index_destroy(&this->son_index_);
 }
 
 void module_load_pla(const void *module_ptr) {
@@ -205,114 +410,90 @@ void module_load_pla(const void *module_ptr) {
         return;
     }
 
-    FILE *file = fopen(this->path_, "r");
-    if (!file) {
-        perror("Failed to open PLA file");
-        return;
-    }
-
-    char line[32];
-    int var_count = 0, num_outputs = 0, num_lines = 0;
-
-    while (fgets(line, sizeof(line), file)) {
-        line[strcspn(line, "\n")] = '\0';
-
-        if (line[0] == '#' || line[0] == '\0') {
-            continue;
-        }
-
-        if (strncmp(line, ".i", 2) == 0) {
-            sscanf(line + 2, "%d", &var_count);
-        } else if (strncmp(line, ".o", 2) == 0) {
-            sscanf(line + 2, "%d", &num_outputs);
-        } else if (strncmp(line, ".p", 2) == 0) {
-            sscanf(line + 2, "%d", &num_lines);
-        } else {
-            break;
-        }
-    }
-
-    if (var_count + num_outputs + num_lines < 3) {
-        fprintf(stderr, "Not enough info (.i, .o, .p)from PLA file.\n");
-        fclose(file);
-        return;
+    pla_function source;
+    if (!pla_function_load_file(&source, this->path_)) {
+        fprintf(stderr, "Failed to load PLA file %s for module %s.\n", this->path_, this->name_);
     }
+    module_load_pla_from(this, &source);
+    pla_function_destroy(&source);
+}
 
+void module_load_pla_from(module *this, pla_function *source) {
     if (!this->function_) {
         this->function_ = malloc(sizeof(pla_function));
     }
-    pla_function_init(this->function_, var_count, num_lines);
-
-    char variables[var_count + 1];
-    char fun_value;
-    int line_index = 0;
-
-    do {
-        line[strcspn(line, "\n")] = '\0';
 
-        if (line[0] == '#' || line[0] == '\0') {
-            continue;
-        }
-
-        if (strcmp(line, ".e") == 0) {
-            break;
+    if (this->output_column_ < 0 || this->output_column_ >= pla_function_get_num_outputs(source)) {
+        if (pla_function_get_num_outputs(source) > 0) {
+            fprintf(stderr, "Output column %d of module %s is out of range.\n", this->output_column_, this->name_);
         }
+        pla_function_init(this->function_, 0, 0);
+        return;
+    }
 
-        sscanf(line, "%s %c", variables, &fun_value);
-
-        pla_function_add_line(this->function_, variables, fun_value, line_index);
-        line_index++;
-    } while (fgets(line, sizeof(line), file));
-
-    fclose(file);
+    pla_function_assign_output(this->function_, source, this->output_column_);
 }
 
 size_t module_serialize(void *payload, void **serialized_payload) {
-    module* this = *(module**)payload;
-    size_t total_size = 0;
-    size_t name_size = strlen(this->name_) + 1;
-
-    total_size += sizeof(size_t) + name_size;
-
-    void* function_payload = NULL;
-    size_t function_size = pla_function_serialize(this->function_, &function_payload);
-    total_size += sizeof(size_t) + function_size;
-
-    void* son_map_payload = NULL;
-    size_t son_map_size = array_list_serialize(this->son_map_, &son_map_payload, son_name_and_pos_serialize);
-    total_size += sizeof(size_t) + son_map_size;
+    size_t total_size = module_write(payload, NULL);
 
     *serialized_payload = malloc(total_size);
     if (!*serialized_payload) {
         perror("Failed to allocate memory for serialized module");
-        free(function_payload);
-        free(son_map_payload);
         return 0;
     }
 
-    char* cursor = *serialized_payload;
+    return module_write(payload, *serialized_payload);
+}
+
+size_t module_write(void *payload, char *buffer) {
+    module* this = *(module**)payload;
+    module_apply_son_shifts(this);
+    // The name is padded with zeros so that the cubes of the function stay 8-byte aligned.
+    size_t name_size = (strlen(this->name_) + sizeof(size_t)) / sizeof(size_t) * sizeof(size_t);
+    size_t function_size = pla_function_write(this->function_, NULL);
+    size_t son_map_size = array_list_write(this->son_map_, NULL, son_name_and_pos_write);
+    // A binary module has no multi-valued function, its size is written as 0.
+    size_t mv_function_size = this->mv_function_ ? mv_function_write(this->mv_function_, NULL) : 0;
+    size_t total_size = sizeof(size_t) * 4 + name_size + function_size + son_map_size + mv_function_size;
+
+    if (!buffer) {
+        return total_size;
+    }
+
+    char* cursor = buffer;
 
     memcpy(cursor, &name_size, sizeof(size_t));
     cursor += sizeof(size_t);
-    memcpy(cursor, this->name_, name_size);
+    memset(cursor, 0, name_size);
+    memcpy(cursor, this->name_, strlen(this->name_));
     cursor += name_size;
 
     memcpy(cursor, &function_size, sizeof(size_t));
     cursor += sizeof(size_t);
-    memcpy(cursor, function_payload, function_size);
+    pla_function_write(this->function_, cursor);
     cursor += function_size;
 
     memcpy(cursor, &son_map_size, sizeof(size_t));
     cursor += sizeof(size_t);
-    memcpy(cursor, son_map_payload, son_map_size);
+    array_list_write(this->son_map_, cursor, son_name_and_pos_write);
+    cursor += son_map_size;
 
-    free(function_payload);
-    free(son_map_payload);
+    memcpy(cursor, &mv_function_size, sizeof(size_t));
+    cursor += sizeof(size_t);
+    if (this->mv_function_) {
+        mv_function_write(this->mv_function_, cursor);
+    }
 
     return total_size;
 }
 
-void * module_deserialize(const void *serialized_payload, size_t size) {
+/**
+ * @brief Deserializes a module, with its function stored in buffer if it is not NULL.
+ *
+ * The function is read last, so a failure never leaves the buffer owned by a freed function.
+ */
+static module* module_deserialize_from(void *buffer, const void *serialized_payload, size_t size) {
     module* this = malloc(sizeof(module));
     if (!this) {
         perror("Failed to allocate memory for module");
@@ -338,13 +519,7 @@ void * module_deserialize(const void *serialized_payload, size_t size) {
     memcpy(&function_size, cursor, sizeof(size_t));
     cursor += sizeof(size_t);
 
-    this->function_ = pla_function_deserialize(cursor, function_size);
-    if (!this->function_) {
-        perror("Failed to deserialize function");
-        free(this->name_);
-        free(this);
-        return NULL;
-    }
+    const char* function_payload = cursor;
     cursor += function_size;
 
     size_t son_map_size;
@@ -354,20 +529,63 @@ void * module_deserialize(const void *serialized_payload, size_t size) {
     this->son_map_ = array_list_deserialize(cursor, son_map_size, son_name_and_pos_deserialize);
     if (!this->son_map_) {
         perror("Failed to deserialize son_map");
-        pla_function_destroy(this->function_);
+        free(this->name_);
+        free(this);
+        return NULL;
+    }
+    cursor += son_map_size;
+
+    size_t mv_function_size;
+    memcpy(&mv_function_size, cursor, sizeof(size_t));
+    cursor += sizeof(size_t);
+    this->mv_function_ = mv_function_size > 0 ? mv_function_deserialize(cursor, mv_function_size) : NULL;
+    if (mv_function_size > 0 && !this->mv_function_) {
+        fprintf(stderr, "Failed to deserialize the multi-valued function of module %s.\n", this->name_);
+        array_list_process_all(this->son_map_, son_name_and_pos_destroy);
+        array_list_destroy(this->son_map_);
+        free(this->son_map_);
         free(this->name_);
         free(this);
         return NULL;
     }
 
+    if (buffer) {
+        this->function_ = pla_function_deserialize_in_place(buffer, (void*)function_payload, function_size);
+    } else {
+        this->function_ = pla_function_deserialize(function_payload, function_size);
+    }
+    if (!this->function_) {
+        perror("Failed to deserialize function");
+        if (this->mv_function_) {
+            mv_function_destroy(this->mv_function_);
+            free(this->mv_function_);
+        }
+        array_list_process_all(this->son_map_, son_name_and_pos_destroy);
+        array_list_destroy(this->son_map_);
+        free(this->son_map_);
+        free(this->name_);
+        free(this);
+        return NULL;
+    }
+
+    son_index_init(&this->son_index_);
     this->parent_ = NULL;
     this->path_ = NULL;
+    this->output_column_ = 0;
     this->assigned_client_ = 0;
     this->priority_ = 0;
 
     return this;
 }
 
+void * module_deserialize(const void *serialized_payload, size_t size) {
+    return module_deserialize_from(NULL, serialized_payload, size);
+}
+
+void * module_deserialize_in_place(void *buffer, void *serialized_payload, size_t size) {
+    return module_deserialize_from(buffer, serialized_payload, size);
+}
+
 void module_print_out(module *this) {
     if (!this) {
         return;
@@ -375,6 +593,7 @@ void module_print_out(module *this) {
     printf("Name: %s\n", this->name_);
     if (this->path_) {
         printf("Path: %s\n", this->path_);
+        printf("Output column: %d\n", this->output_column_);
     }
     if (this->parent_) {
         printf("Parent: %s\n", module_get_name(this->parent_));
@@ -382,10 +601,14 @@ void module_print_out(module *this) {
     printf("Assigned Client: %d\n", this->assigned_client_);
     printf("Priority: %d\n", this->priority_);
     if (array_list_get_size(this->son_map_) > 0) {
+        module_apply_son_shifts(this);
         printf("Son map:\n");
         array_list_process_all(this->son_map_, print_son_map);
     }
-    if (this->function_) {
+    if (this->mv_function_) {
+        printf("Function:\n");
+        mv_function_print_function(this->mv_function_);
+    } else if (this->function_) {
         printf("Function:\n");
         pla_function_print_function(this->function_);
     }
@@ -3,16 +3,30 @@
 
 #include "array_list.h"
 #include "pla_function.h"
+#include "mv_function.h"
+
+/**
+ * @brief Ways of merging son functions into their parent.
+ *
+ * - MODULE_MERGE_CUBES: Products of the cubes of both values.
+ * - MODULE_MERGE_ON_SET: Products of the on-set cubes, son off-sets are complemented.
+ * - MODULE_MERGE_BDD: Composition of reduced ordered BDDs, see bdd_input_variables, falls back to MODULE_MERGE_ON_SET for results over BDD_MAX_PLA_LINES cubes.
+ */
+typedef enum module_merge_mode {
+    MODULE_MERGE_CUBES,
+    MODULE_MERGE_ON_SET,
+    MODULE_MERGE_BDD
+} module_merge_mode;
 
 /**
  * @brief Represents a mapping of a son's name to its position.
  *
  * Fields:
- * - son_name_: Name of the son (max 7 characters + null terminator).
+ * - son_name_: Name of the son, owned by the structure.
  * - son_position_: Position of the son in the hierarchy.
  */
 typedef struct son_name_and_pos {
-    char son_name_[8];
+    char* son_name_;
     int son_position_;
 } son_name_and_pos;
 
@@ -46,6 +60,14 @@ _Bool son_name_and_pos_compare_name(const void *item, void *property);
  */
 size_t son_name_and_pos_serialize(void* item, void** serialized_payload);
 
+/**
+ * @brief Writes a son_name_and_pos structure in the serialized format directly into a buffer.
+ * @param item Pointer to the structure to serialize.
+ * @param buffer Output buffer, or NULL to only compute the size.
+ * @return Size of the serialized structure.
+ */
+size_t son_name_and_pos_write(void* item, char* buffer);
+
 /**
  * @brief Deserializes a buffer into a son_name_and_pos structure.
  * @param serialized_payload Pointer to the serialized buffer.
@@ -54,24 +76,103 @@ size_t son_name_and_pos_serialize(void* item, void** serialized_payload);
  */
 void* son_name_and_pos_deserialize(const void* serialized_payload, size_t size);
 
+/**
+ * @brief Entry of the son index sorted by son name.
+ *
+ * Fields:
+ * - son_name_: Name of the son, borrowed from the son map.
+ * - son_index_: Index of the son in the son map.
+ */
+typedef struct son_index_entry {
+    char* son_name_;
+    int son_index_;
+} son_index_entry;
+
+/**
+ * @brief Index over the son map of a module.
+ *
+ * Sons are found by binary search over by_name_. Position shifts caused by
+ * merged sons are kept in a Fenwick tree over the son map order, so both
+ * looking up a position and shifting all later sons take O(log n).
+ *
+ * Fields:
+ * - by_name_: Sons sorted by name.
+ * - shifts_: Fenwick tree (1-based) of position shifts.
+ * - size_: Number of indexed sons.
+ */
+typedef struct son_index {
+    son_index_entry* by_name_;
+    int* shifts_;
+    int size_;
+} son_index;
+
+/**
+ * @brief Initializes an empty son index.
+ * @param this Pointer to the son index.
+ */
+void son_index_init(son_index *this);
+
+/**
+ * @brief Destroys a son index.
+ * @param this Pointer to the son index.
+ */
+void son_index_destroy(son_index *this);
+
+/**
+ * @brief Builds the son index over a son map, with no shifts.
+ * @param this Pointer to the son index.
+ * @param son_map Array list of son_name_and_pos structures.
+ */
+void son_index_build(son_index *this, array_list *son_map);
+
+/**
+ * @brief Finds a son in the son index.
+ * @param this Pointer to the son index.
+ * @param son_name Name of the son.
+ * @return Index of the son in the son map, or -1 if not found.
+ */
+int son_index_find(son_index *this, char *son_name);
+
+/**
+ * @brief Gets the total position shift of a son.
+ * @param this Pointer to the son index.
+ * @param son_index Index of the son in the son map.
+ * @return Shift to add to the stored son position.
+ */
+int son_index_get_shift(son_index *this, int son_index);
+
+/**
+ * @brief Shifts the positions of a son and all sons after it.
+ * @param this Pointer to the son index.
+ * @param first_son_index Index of the first shifted son in the son map.
+ * @param shift Shift to add.
+ */
+void son_index_add_shift(son_index *this, int first_son_index, int shift);
+
 /**
  * @brief Represents a module with parent-child relationships and functionality.
  *
  * Fields:
  * - parent_: Pointer to the parent module.
- * - function_: Pointer to the module's function (PLA structure).
+ * - function_: Pointer to the module's function (PLA structure), empty for a multi-valued module.
+ * - mv_function_: Pointer to the multi-valued function of the module, or NULL for a binary module.
  * - son_map_: Array list mapping son's names to their positions.
+ * - son_index_: Index for looking up and shifting son positions.
  * - name_: Name of the module.
  * - path_: File path associated with the module.
+ * - output_column_: Output column of the PLA file the module represents.
  * - assigned_client_: ID of the client the module is assigned to.
  * - priority_: Priority level of the module.
  */
 typedef struct module {
     struct module* parent_;
     pla_function* function_;
+    mv_function* mv_function_;
     array_list* son_map_;
+    son_index son_index_;
     char* name_;
     char* path_;
+    int output_column_;
     int assigned_client_;
     int priority_;
 } module;
@@ -102,6 +203,21 @@ void module_destroy_array_list(const void* item);
  */
 pla_function* module_get_function(module* this);
 
+/**
+ * @brief Gets the multi-valued function of a module.
+ * @param this Pointer to the module.
+ * @return Pointer to the multi-valued function, or NULL for a binary module.
+ */
+mv_function* module_get_mv_function(module* this);
+
+/**
+ * @brief Makes the module multi-valued, with an empty multi-valued function.
+ *
+ * The module is then loaded by mv_function_load_file and its output column is ignored.
+ * @param this Pointer to the module.
+ */
+void module_set_multi_valued(module* this);
+
 /**
  * @brief Gets the parent of a module.
  * @param this Pointer to the module.
@@ -131,6 +247,13 @@ int module_get_priority(module* this);
  */
 int module_get_var_count(module* this);
 
+/**
+ * @brief Gets the number of lines in the module's function.
+ * @param this Pointer to the module.
+ * @return Number of lines.
+ */
+int module_get_num_lines(module* this);
+
 /**
  * @brief Gets the assigned client ID of the module.
  * @param this Pointer to the module.
@@ -152,6 +275,20 @@ int module_get_son_count(module* this);
  */
 char* module_get_name(module* this);
 
+/**
+ * @brief Gets the path associated with the module.
+ * @param this Pointer to the module.
+ * @return File path, or NULL if not set.
+ */
+char* module_get_path(module* this);
+
+/**
+ * @brief Gets the output column of the PLA file the module represents.
+ * @param this Pointer to the module.
+ * @return Output column.
+ */
+int module_get_output_column(module* this);
+
 /**
  * @brief Sets the client ID for the module.
  * @param this Pointer to the module.
@@ -173,6 +310,13 @@ void module_set_parent(module* this, module* parent);
  */
 void module_set_path(module* this, char* path);
 
+/**
+ * @brief Sets the output column of the PLA file the module represents.
+ * @param this Pointer to the module.
+ * @param output_column Output column to set.
+ */
+void module_set_output_column(module* this, int output_column);
+
 
 /**
  * @brief Compares the priority of two modules.
@@ -215,13 +359,21 @@ void module_add_son(module* this, module* son, int son_position);
 void module_add_son_position(module* this, char* son_name, int son_position);
 
 /**
- * @brief Adjusts the positions of sons in the module after a new son is added.
+ * @brief Adjusts the positions of sons in the module after a son is merged.
+ *
+ * The shift is only recorded in the son index, see module_apply_son_shifts.
  * @param this Pointer to the module.
  * @param added_son Name of the added son.
  * @param son_var_count Number of variables in the added son's function.
  */
 void module_adjust_positions(module* this, char* added_son, int son_var_count);
 
+/**
+ * @brief Writes the shifts recorded in the son index into the son map.
+ * @param this Pointer to the module.
+ */
+void module_apply_son_shifts(module* this);
+
 
 /**
  * @brief Loads a PLA file for the module and initializes its function.
@@ -229,6 +381,16 @@ void module_adjust_positions(module* this, char* added_son, int son_var_count);
  */
 void module_load_pla(const void* module_ptr);
 
+/**
+ * @brief Initializes the module's function from an already parsed PLA file.
+ *
+ * Only the module's output column is copied, so one parsed file can be
+ * shared by every module pointing at it.
+ * @param this Pointer to the module.
+ * @param source Pointer to the parsed multi-output PLA function.
+ */
+void module_load_pla_from(module* this, pla_function* source);
+
 /**
  * @brief Creates a function for the module with specified dimensions.
  * @param this Pointer to the module.
@@ -245,6 +407,19 @@ void module_create_function(module* this, int var_count, int line_count);
  */
 void module_merge_modules(module* parent, module* son);
 
+/**
+ * @brief Merges several son modules into their parent in one pass.
+ *
+ * If the parent or a son is multi-valued, the parent becomes multi-valued,
+ * binary functions are converted by mv_function_from_pla and the sons are
+ * merged one by one by mv_function_input_variables, regardless of mode.
+ * @param parent Pointer to the parent module.
+ * @param sons Array of pointers to the son modules.
+ * @param count Number of sons.
+ * @param mode Way of merging the son functions.
+ */
+void module_merge_sons(module* parent, module** sons, int count, module_merge_mode mode);
+
 /**
  * @brief Serializes a module into a buffer.
  * @param payload Pointer to the module to serialize.
@@ -253,6 +428,17 @@ void module_merge_modules(module* parent, module* son);
  */
 size_t module_serialize(void* payload, void** serialized_payload);
 
+/**
+ * @brief Writes a module in the format of module_serialize directly into a buffer.
+ *
+ * The name, the cubes of the function, the son map and the multi-valued
+ * function, if any, are copied once, without intermediate buffers.
+ * @param payload Pointer to the module to serialize.
+ * @param buffer Output buffer, or NULL to only compute the size.
+ * @return Size of the serialized module.
+ */
+size_t module_write(void* payload, char* buffer);
+
 /**
  * @brief Deserializes a module from a buffer.
  * @param serialized_payload Pointer to the serialized buffer.
@@ -261,6 +447,17 @@ size_t module_serialize(void* payload, void** serialized_payload);
  */
 void* module_deserialize(const void* serialized_payload, size_t size);
 
+/**
+ * @brief Deserializes a module whose function keeps its cubes in the serialized buffer.
+ *
+ * On success the function of the module takes ownership of the buffer.
+ * @param buffer Allocation containing the serialized module.
+ * @param serialized_payload Pointer to the serialized module inside the buffer.
+ * @param size Size of the serialized module.
+ * @return Pointer to the deserialized module, or NULL without taking the buffer.
+ */
+void* module_deserialize_in_place(void* buffer, void* serialized_payload, size_t size);
+
 
 /**
  * @brief Prints the sons in the module's son map.
@@ -0,0 +1,520 @@
+#include "mv_function.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+static uint32_t mv_full_literal(int domain) {
+    return (uint32_t)((UINT64_C(1) << domain) - 1);
+}
+
+static int mv_function_layout(const int* domains, int var_count, int* offsets) {
+    int offset = 0;
+    for (int i = 0; i < var_count; i++) {
+        if (offset % 64 + domains[i] > 64) {
+            offset = (offset / 64 + 1) * 64;
+        }
+        offsets[i] = offset;
+        offset += domains[i];
+    }
+    return (offset + 63) / 64;
+}
+
+void mv_function_init(mv_function *this, int var_count, const int *domains, int output_domain, int line_count) {
+    this->num_lines_ = line_count;
+    this->var_count_ = var_count;
+    this->output_domain_ = output_domain;
+    this->domains_ = malloc((var_count > 0 ? var_count : 1) * sizeof(int));
+    this->offsets_ = malloc((var_count > 0 ? var_count : 1) * sizeof(int));
+    if (var_count > 0) {
+        memcpy(this->domains_, domains, var_count * sizeof(int));
+    }
+    this->words_per_cube_ = mv_function_layout(this->domains_, var_count, this->offsets_);
+    this->value_counts_ = calloc(output_domain > 0 ? output_domain : 1, sizeof(int));
+    this->cubes_ = calloc((size_t)line_count * this->words_per_cube_ + 1, sizeof(uint64_t));
+    this->values_ = calloc(line_count > 0 ? line_count : 1, sizeof(unsigned char));
+}
+
+void mv_function_destroy(mv_function *this) {
+    free(this->cubes_);
+    free(this->values_);
+    free(this->value_counts_);
+    free(this->domains_);
+    free(this->offsets_);
+    this->cubes_ = NULL;
+    this->values_ = NULL;
+    this->value_counts_ = NULL;
+    this->domains_ = NULL;
+    this->offsets_ = NULL;
+    this->num_lines_ = 0;
+    this->var_count_ = 0;
+    this->output_domain_ = 0;
+    this->words_per_cube_ = 0;
+}
+
+void mv_function_move(mv_function *this, mv_function *other) {
+    if (this == other) {
+        return;
+    }
+    mv_function_destroy(this);
+    *this = *other;
+    other->cubes_ = NULL;
+    other->values_ = NULL;
+    other->value_counts_ = NULL;
+    other->domains_ = NULL;
+    other->offsets_ = NULL;
+    other->num_lines_ = 0;
+    other->var_count_ = 0;
+    other->output_domain_ = 0;
+    other->words_per_cube_ = 0;
+}
+
+uint64_t * mv_function_get_cube(mv_function *this, int line_num) {
+    return this->cubes_ + (size_t)line_num * this->words_per_cube_;
+}
+
+int mv_function_get_value(mv_function *this, int line_num) {
+    return this->values_[line_num];
+}
+
+int mv_function_get_num_lines(mv_function *this) {
+    return this->num_lines_;
+}
+
+int mv_function_get_var_count(mv_function *this) {
+    return this->var_count_;
+}
+
+int mv_function_get_domain(mv_function *this, int position) {
+    return this->domains_[position];
+}
+
+int mv_function_get_output_domain(mv_function *this) {
+    return this->output_domain_;
+}
+
+int * mv_function_get_value_counts(mv_function *this) {
+    return this->value_counts_;
+}
+
+uint32_t mv_cube_get_literal(const mv_function *this, const uint64_t *cube, int position) {
+    int offset = this->offsets_[position];
+    return (uint32_t)(cube[offset / 64] >> (offset % 64)) & mv_full_literal(this->domains_[position]);
+}
+
+void mv_cube_set_literal(const mv_function *this, uint64_t *cube, int position, uint32_t literal) {
+    int offset = this->offsets_[position];
+    uint64_t mask = (uint64_t)mv_full_literal(this->domains_[position]) << (offset % 64);
+    cube[offset / 64] = (cube[offset / 64] & ~mask) | (((uint64_t)literal << (offset % 64)) & mask);
+}
+
+void mv_function_add_cube(mv_function *this, const uint64_t *cube, int value, int line_num) {
+    memcpy(mv_function_get_cube(this, line_num), cube, this->words_per_cube_ * sizeof(uint64_t));
+    this->values_[line_num] = (unsigned char)value;
+    this->value_counts_[value]++;
+}
+
+void mv_function_from_pla(mv_function *this, pla_function *function) {
+    int var_count = pla_function_get_var_count(function);
+    int* fun_val_count = pla_function_get_fun_val_count(function);
+    int* domains = malloc((var_count > 0 ? var_count : 1) * sizeof(int));
+    for (int i = 0; i < var_count; i++) {
+        domains[i] = 2;
+    }
+    mv_function_init(this, var_count, domains, 2, fun_val_count[0] + fun_val_count[1]);
+    free(domains);
+
+    // Binary literals have the PLA_LITERAL_* layout, so whole cubes are copied.
+    int line_num = 0;
+    for (int i = 0; i < pla_function_get_num_lines(function); i++) {
+        char value = pla_function_get_value(function, i);
+        if (value == '0' || value == '1') {
+            mv_function_add_cube(this, pla_function_get_cube(function, i), value - '0', line_num++);
+        }
+    }
+}
+
+static void mv_literal_to_text(const mv_function* this, const uint64_t* cube, int position, char* text) {
+    uint32_t literal = mv_cube_get_literal(this, cube, position);
+    int domain = this->domains_[position];
+    if (domain == 2) {
+        text[0] = literal == PLA_LITERAL_ZERO ? '0' : literal == PLA_LITERAL_ONE ? '1' : '-';
+        text[1] = '\0';
+        return;
+    }
+    for (int j = 0; j < domain; j++) {
+        text[j] = (literal >> j) & 1 ? '1' : '0';
+    }
+    text[domain] = '\0';
+}
+
+void mv_function_print_function(mv_function *this) {
+    char text[MV_FUNCTION_MAX_DOMAIN + 1];
+    for (int i = 0; i < this->num_lines_; i++) {
+        uint64_t* cube = mv_function_get_cube(this, i);
+        for (int position = 0; position < this->var_count_; position++) {
+            mv_literal_to_text(this, cube, position, text);
+            printf(this->domains_[position] == 2 ? "%s" : " %s ", text);
+        }
+        printf(" %d\n", this->values_[i]);
+    }
+}
+
+_Bool mv_function_input_variables(mv_function *this, mv_function *other, int position) {
+    if (mv_function_get_output_domain(other) != this->domains_[position]) {
+        return false;
+    }
+
+    int other_var_count = mv_function_get_var_count(other);
+    int new_var_count = this->var_count_ + other_var_count - 1;
+    int* new_domains = malloc((new_var_count > 0 ? new_var_count : 1) * sizeof(int));
+    memcpy(new_domains, this->domains_, position * sizeof(int));
+    memcpy(new_domains + position, other->domains_, other_var_count * sizeof(int));
+    memcpy(new_domains + position + other_var_count, this->domains_ + position + 1, (this->var_count_ - position - 1) * sizeof(int));
+
+    int domain = this->domains_[position];
+    uint32_t full = mv_full_literal(domain);
+    int* value_starts = calloc(domain + 1, sizeof(int));
+    int* by_value = malloc((other->num_lines_ > 0 ? other->num_lines_ : 1) * sizeof(int));
+    for (int value = 0; value < domain; value++) {
+        value_starts[value + 1] = value_starts[value] + other->value_counts_[value];
+    }
+    int* next = malloc(domain * sizeof(int));
+    memcpy(next, value_starts, domain * sizeof(int));
+    for (int i = 0; i < other->num_lines_; i++) {
+        by_value[next[other->values_[i]]++] = i;
+    }
+    free(next);
+
+    int new_line_count = 0;
+    for (int i = 0; i < this->num_lines_; i++) {
+        uint32_t literal = mv_cube_get_literal(this, mv_function_get_cube(this, i), position);
+        if (literal == full) {
+            new_line_count++;
+            continue;
+        }
+        for (int value = 0; value < domain; value++) {
+            if ((literal >> value) & 1) {
+                new_line_count += other->value_counts_[value];
+            }
+        }
+    }
+
+    mv_function new_function;
+    mv_function_init(&new_function, new_var_count, new_domains, this->output_domain_, new_line_count);
+    free(new_domains);
+
+    uint64_t base[new_function.words_per_cube_ + 1];
+    int line_num = 0;
+    for (int i = 0; i < this->num_lines_; i++) {
+        uint64_t* cube = mv_function_get_cube(this, i);
+        int fun_value = this->values_[i];
+
+        memset(base, 0, sizeof(base));
+        for (int j = 0; j < position; j++) {
+            mv_cube_set_literal(&new_function, base, j, mv_cube_get_literal(this, cube, j));
+        }
+        for (int j = 0; j < other_var_count; j++) {
+            mv_cube_set_literal(&new_function, base, position + j, mv_full_literal(other->domains_[j]));
+        }
+        for (int j = position + 1; j < this->var_count_; j++) {
+            mv_cube_set_literal(&new_function, base, j + other_var_count - 1, mv_cube_get_literal(this, cube, j));
+        }
+
+        uint32_t literal = mv_cube_get_literal(this, cube, position);
+        if (literal == full) {
+            mv_function_add_cube(&new_function, base, fun_value, line_num++);
+            continue;
+        }
+        for (int value = 0; value < domain; value++) {
+            if (!((literal >> value) & 1)) {
+                continue;
+            }
+            for (int k = value_starts[value]; k < value_starts[value + 1]; k++) {
+                uint64_t* other_cube = mv_function_get_cube(other, by_value[k]);
+                uint64_t* new_cube = mv_function_get_cube(&new_function, line_num);
+                memcpy(new_cube, base, new_function.words_per_cube_ * sizeof(uint64_t));
+                for (int j = 0; j < other_var_count; j++) {
+                    mv_cube_set_literal(&new_function, new_cube, position + j, mv_cube_get_literal(other, other_cube, j));
+                }
+                new_function.values_[line_num] = (unsigned char)fun_value;
+                new_function.value_counts_[fun_value]++;
+                line_num++;
+            }
+        }
+    }
+
+    mv_function_move(this, &new_function);
+
+    free(by_value);
+    free(value_starts);
+    return true;
+}
+
+static _Bool mv_is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '|';
+}
+
+static const char* mv_skip_blanks(const char* cursor, const char* line_end) {
+    while (cursor < line_end && mv_is_blank(*cursor)) {
+        cursor++;
+    }
+    return cursor;
+}
+
+static const char* mv_parse_int(const char* cursor, const char* line_end, int* value) {
+    cursor = mv_skip_blanks(cursor, line_end);
+    *value = -1;
+    if (cursor < line_end && *cursor >= '0' && *cursor <= '9') {
+        *value = 0;
+    }
+    while (cursor < line_end && *cursor >= '0' && *cursor <= '9') {
+        *value = *value * 10 + (*cursor - '0');
+        cursor++;
+    }
+    return cursor;
+}
+
+static _Bool mv_keyword_equals(const char* keyword, size_t keyword_length, const char* expected) {
+    return keyword_length == strlen(expected) && memcmp(keyword, expected, keyword_length) == 0;
+}
+
+static _Bool mv_function_parse_cube(mv_function* this, const char* cursor, const char* line_end, int line_num) {
+    uint64_t* cube = mv_function_get_cube(this, line_num);
+    memset(cube, 0, this->words_per_cube_ * sizeof(uint64_t));
+
+    for (int position = 0; position < this->var_count_; position++) {
+        cursor = mv_skip_blanks(cursor, line_end);
+        if (cursor >= line_end) {
+            return false;
+        }
+        int domain = this->domains_[position];
+        uint32_t literal = 0;
+        if (*cursor == '-') {
+            literal = mv_full_literal(domain);
+            cursor++;
+        } else if (domain == 2) {
+            literal = *cursor == '0' ? PLA_LITERAL_ZERO : *cursor == '1' ? PLA_LITERAL_ONE : PLA_LITERAL_DONT_CARE;
+            cursor++;
+        } else {
+            for (int j = 0; j < domain; j++) {
+                if (cursor >= line_end) {
+                    return false;
+                }
+                if (*cursor++ == '1') {
+                    literal |= UINT32_C(1) << j;
+                }
+            }
+        }
+        mv_cube_set_literal(this, cube, position, literal);
+    }
+
+    int value;
+    mv_parse_int(cursor, line_end, &value);
+    if (value < 0 || value >= this->output_domain_) {
+        return false;
+    }
+    this->values_[line_num] = (unsigned char)value;
+    this->value_counts_[value]++;
+    return true;
+}
+
+_Bool mv_function_parse(mv_function *this, const char *text, size_t length) {
+    const char* end = text + length;
+    const char* cursor = text;
+    const char* body = NULL;
+    const char* body_end = end;
+    const char* domains_text = NULL;
+    const char* domains_end = NULL;
+    int var_count = 0, line_count = 0;
+
+    while (cursor < end) {
+        const char* line_end = memchr(cursor, '\n', end - cursor);
+        if (!line_end) {
+            line_end = end;
+        }
+        const char* start = mv_skip_blanks(cursor, line_end);
+
+        if (start < line_end && *start == '.') {
+            const char* keyword_end = start;
+            while (keyword_end < line_end && !mv_is_blank(*keyword_end)) {
+                keyword_end++;
+            }
+            size_t keyword_length = keyword_end - start;
+            if (mv_keyword_equals(start, keyword_length, ".e") || mv_keyword_equals(start, keyword_length, ".end")) {
+                body_end = cursor;
+                break;
+            }
+            if (mv_keyword_equals(start, keyword_length, ".i")) {
+                mv_parse_int(keyword_end, line_end, &var_count);
+            } else if (mv_keyword_equals(start, keyword_length, ".mv")) {
+                domains_text = keyword_end;
+                domains_end = line_end;
+            }
+        } else if (start < line_end && *start != '#') {
+            if (!body) {
+                body = cursor;
+            }
+            line_count++;
+        }
+
+        cursor = line_end + 1;
+    }
+
+    if (var_count <= 0) {
+        fprintf(stderr, "Not enough info (.i) from multi-valued PLA file.\n");
+        mv_function_init(this, 0, NULL, 0, 0);
+        return false;
+    }
+
+    int* domains = malloc((var_count + 1) * sizeof(int));
+    for (int i = 0; i <= var_count; i++) {
+        domains[i] = 2;
+        if (domains_text) {
+            domains_text = mv_parse_int(domains_text, domains_end, &domains[i]);
+        }
+        if (domains[i] < 2 || domains[i] > MV_FUNCTION_MAX_DOMAIN) {
+            fprintf(stderr, "Invalid .mv line in multi-valued PLA file.\n");
+            free(domains);
+            mv_function_init(this, 0, NULL, 0, 0);
+            return false;
+        }
+    }
+
+    mv_function_init(this, var_count, domains, domains[var_count], line_count);
+    free(domains);
+
+    int line_index = 0;
+    cursor = body ? body : body_end;
+    while (cursor < body_end) {
+        const char* line_end = memchr(cursor, '\n', body_end - cursor);
+        if (!line_end) {
+            line_end = body_end;
+        }
+        const char* start = mv_skip_blanks(cursor, line_end);
+
+        if (start < line_end && *start != '#' && *start != '.') {
+            if (mv_function_parse_cube(this, start, line_end, line_index)) {
+                line_index++;
+            }
+        }
+
+        cursor = line_end + 1;
+    }
+
+    this->num_lines_ = line_index;
+    return true;
+}
+
+_Bool mv_function_load_file(mv_function *this, const char *path) {
+    size_t length = 0;
+    const char* text = pla_function_map_file(path, &length);
+    if (!text) {
+        mv_function_init(this, 0, NULL, 0, 0);
+        return false;
+    }
+
+    _Bool result = mv_function_parse(this, text, length);
+
+    pla_function_unmap_file(text, length);
+    return result;
+}
+
+size_t mv_function_serialize(void *payload, void **serialized_payload) {
+    size_t total_size = mv_function_write(payload, NULL);
+
+    *serialized_payload = malloc(total_size);
+
+    return mv_function_write(payload, *serialized_payload);
+}
+
+size_t mv_function_write(void *payload, char *buffer) {
+    mv_function *this = (mv_function *)payload;
+
+    size_t cubes_size = (size_t)this->num_lines_ * this->words_per_cube_ * sizeof(uint64_t);
+    size_t total_size = 0;
+
+    total_size += sizeof(int) * 3;
+    total_size += sizeof(int) * this->var_count_;
+    total_size += cubes_size;
+    total_size += this->num_lines_;
+
+    if (!buffer) {
+        return total_size;
+    }
+
+    char *current_ptr = buffer;
+
+    memcpy(current_ptr, &this->var_count_, sizeof(int));
+    current_ptr += sizeof(int);
+    memcpy(current_ptr, &this->output_domain_, sizeof(int));
+    current_ptr += sizeof(int);
+    memcpy(current_ptr, &this->num_lines_, sizeof(int));
+    current_ptr += sizeof(int);
+    memcpy(current_ptr, this->domains_, sizeof(int) * this->var_count_);
+    current_ptr += sizeof(int) * this->var_count_;
+
+    memcpy(current_ptr, this->cubes_, cubes_size);
+    current_ptr += cubes_size;
+    memcpy(current_ptr, this->values_, this->num_lines_);
+
+    return total_size;
+}
+
+void * mv_function_deserialize(const void *serialized_payload, size_t size) {
+    if (!serialized_payload || size < sizeof(int) * 3) {
+        return NULL;
+    }
+
+    const char* buffer = (const char*)serialized_payload;
+    int var_count, output_domain, num_lines;
+
+    memcpy(&var_count, buffer, sizeof(int));
+    buffer += sizeof(int);
+    memcpy(&output_domain, buffer, sizeof(int));
+    buffer += sizeof(int);
+    memcpy(&num_lines, buffer, sizeof(int));
+    buffer += sizeof(int);
+
+    // The buffer comes from the network, so every count is checked against its size before it is used.
+    size_t remaining = size - sizeof(int) * 3;
+    if (var_count < 0 || num_lines < 0 || output_domain < 0 || output_domain > MV_FUNCTION_MAX_DOMAIN ||
+        (size_t)var_count > remaining / sizeof(int)) {
+        return NULL;
+    }
+    int* domains = malloc((var_count > 0 ? var_count : 1) * sizeof(int));
+    int* offsets = malloc((var_count > 0 ? var_count : 1) * sizeof(int));
+    memcpy(domains, buffer, sizeof(int) * var_count);
+    buffer += sizeof(int) * var_count;
+    remaining -= sizeof(int) * var_count;
+    _Bool valid = true;
+    for (int i = 0; i < var_count; i++) {
+        valid = valid && domains[i] >= 2 && domains[i] <= MV_FUNCTION_MAX_DOMAIN;
+    }
+    size_t cube_size = valid ? (size_t)mv_function_layout(domains, var_count, offsets) * sizeof(uint64_t) : 0;
+    free(offsets);
+    if (!valid || remaining / (cube_size + 1) < (size_t)num_lines || remaining != (size_t)num_lines * (cube_size + 1)) {
+        free(domains);
+        return NULL;
+    }
+
+    const unsigned char* values = (const unsigned char*)buffer + (size_t)num_lines * cube_size;
+    for (int i = 0; i < num_lines; i++) {
+        if (values[i] >= output_domain) {
+            free(domains);
+            return NULL;
+        }
+    }
+
+    mv_function* deserialized = malloc(sizeof(mv_function));
+    mv_function_init(deserialized, var_count, domains, output_domain, num_lines);
+    free(domains);
+
+    memcpy(deserialized->cubes_, buffer, (size_t)num_lines * cube_size);
+    memcpy(deserialized->values_, values, num_lines);
+    for (int i = 0; i < num_lines; i++) {
+        deserialized->value_counts_[deserialized->values_[i]]++;
+    }
+
+    return deserialized;
+}
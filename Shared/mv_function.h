@@ -0,0 +1,218 @@
+#ifndef MV_FUNCTION_H
+#define MV_FUNCTION_H
+#include <stddef.h>
+#include <stdint.h>
+#include "pla_function.h"
+
+/**
+ * @brief Literal encoding used by multi-valued cubes.
+ *
+ * A literal of a variable with k values takes k bits, bit j is set when the
+ * variable can have the value j. Literals never cross a 64-bit word, so a
+ * binary variable uses the same two bits as a PLA_LITERAL_* literal.
+ */
+#define MV_FUNCTION_MAX_DOMAIN 32
+
+/**
+ * @brief Represents a function of multi-valued inputs with a multi-valued output.
+ *
+ * Fields:
+ * - cubes_: Contiguous block of packed input cubes, words_per_cube_ words per line.
+ * - values_: Output value of every line.
+ * - value_counts_: Number of lines with every output value.
+ * - domains_: Number of values of every input variable.
+ * - offsets_: Bit offset of the literal of every input variable in a cube.
+ * - num_lines_: Number of lines (rows).
+ * - var_count_: Number of input variables.
+ * - output_domain_: Number of output values.
+ * - words_per_cube_: Number of 64-bit words used by one packed cube.
+ */
+typedef struct mv_function {
+    uint64_t* cubes_;
+    unsigned char* values_;
+    int* value_counts_;
+    int* domains_;
+    int* offsets_;
+    int num_lines_;
+    int var_count_;
+    int output_domain_;
+    int words_per_cube_;
+} mv_function;
+
+/**
+ * @brief Initializes a multi-valued function with zeroed lines.
+ * @param this Pointer to the function.
+ * @param var_count Number of input variables.
+ * @param domains Number of values of every input variable, at most MV_FUNCTION_MAX_DOMAIN.
+ * @param output_domain Number of output values.
+ * @param line_count Number of lines.
+ */
+void mv_function_init(mv_function* this, int var_count, const int* domains, int output_domain, int line_count);
+
+/**
+ * @brief Destroys a multi-valued function.
+ * @param this Pointer to the function.
+ */
+void mv_function_destroy(mv_function* this);
+
+/**
+ * @brief Moves the storage of another function into this one, leaving the other empty.
+ * @param this Pointer to the target function.
+ * @param other Pointer to the source function.
+ */
+void mv_function_move(mv_function* this, mv_function* other);
+
+/**
+ * @brief Gets the packed cube of a line.
+ * @param this Pointer to the function.
+ * @param line_num Line number.
+ * @return Pointer to the first word of the cube.
+ */
+uint64_t* mv_function_get_cube(mv_function* this, int line_num);
+
+/**
+ * @brief Gets the output value of a line.
+ * @param this Pointer to the function.
+ * @param line_num Line number.
+ * @return Output value.
+ */
+int mv_function_get_value(mv_function* this, int line_num);
+
+/**
+ * @brief Gets the number of lines.
+ * @param this Pointer to the function.
+ * @return Number of lines.
+ */
+int mv_function_get_num_lines(mv_function* this);
+
+/**
+ * @brief Gets the number of input variables.
+ * @param this Pointer to the function.
+ * @return Number of input variables.
+ */
+int mv_function_get_var_count(mv_function* this);
+
+/**
+ * @brief Gets the number of values of an input variable.
+ * @param this Pointer to the function.
+ * @param position Position of the variable.
+ * @return Number of values.
+ */
+int mv_function_get_domain(mv_function* this, int position);
+
+/**
+ * @brief Gets the number of output values.
+ * @param this Pointer to the function.
+ * @return Number of output values.
+ */
+int mv_function_get_output_domain(mv_function* this);
+
+/**
+ * @brief Gets the number of lines with every output value.
+ * @param this Pointer to the function.
+ * @return Array of output_domain_ counts.
+ */
+int* mv_function_get_value_counts(mv_function* this);
+
+/**
+ * @brief Gets the literal of a variable in a cube.
+ * @param this Pointer to the function owning the cube layout.
+ * @param cube Pointer to the packed cube.
+ * @param position Position of the variable.
+ * @return Mask of the values allowed by the literal.
+ */
+uint32_t mv_cube_get_literal(const mv_function* this, const uint64_t* cube, int position);
+
+/**
+ * @brief Sets the literal of a variable in a cube.
+ * @param this Pointer to the function owning the cube layout.
+ * @param cube Pointer to the packed cube.
+ * @param position Position of the variable.
+ * @param literal Mask of the values allowed by the literal.
+ */
+void mv_cube_set_literal(const mv_function* this, uint64_t* cube, int position, uint32_t literal);
+
+/**
+ * @brief Copies a cube and its output value into a line.
+ * @param this Pointer to the function.
+ * @param cube Pointer to the packed cube.
+ * @param value Output value.
+ * @param line_num Line number.
+ */
+void mv_function_add_cube(mv_function* this, const uint64_t* cube, int value, int line_num);
+
+/**
+ * @brief Converts the '0' and '1' lines of a PLA function into a binary valued function.
+ * @param this Pointer to the uninitialized function.
+ * @param function Pointer to the PLA function.
+ */
+void mv_function_from_pla(mv_function* this, pla_function* function);
+
+/**
+ * @brief Prints the lines of the function.
+ * @param this Pointer to the function.
+ */
+void mv_function_print_function(mv_function* this);
+
+/**
+ * @brief Inputs the variables of another function in place of one variable.
+ *
+ * A line whose literal at the position allows the values S is replaced by
+ * every line of the other function with an output value from S, so the
+ * other function must cover every input with exactly one output value.
+ * @param this Pointer to the target function.
+ * @param other Pointer to the source function.
+ * @param position Position of the replaced variable.
+ * @return true if the functions were merged, false if the output domain of
+ * the source does not match the domain of the variable.
+ */
+_Bool mv_function_input_variables(mv_function* this, mv_function* other, int position);
+
+/**
+ * @brief Parses the text of a multi-valued PLA file.
+ *
+ * The .mv line lists the number of values of every input followed by the
+ * number of output values, missing .mv means binary variables. A binary
+ * literal is one of '0', '1', '-', a literal with k values is k characters
+ * where the j-th is '1' if the value j is allowed, or '-' for any value.
+ * The output is a decimal value, lines with '-' output are skipped.
+ * @param this Pointer to the uninitialized function.
+ * @param text Pointer to the file contents (does not need to be null terminated).
+ * @param length Length of the contents.
+ * @return true if the function was parsed, false otherwise.
+ */
+_Bool mv_function_parse(mv_function* this, const char* text, size_t length);
+
+/**
+ * @brief Maps a multi-valued PLA file into memory and parses it.
+ * @param this Pointer to the uninitialized function.
+ * @param path Path to the file.
+ * @return true if the file was loaded, false otherwise.
+ */
+_Bool mv_function_load_file(mv_function* this, const char* path);
+
+/**
+ * @brief Serializes a multi-valued function into a buffer.
+ * @param payload Pointer to the function.
+ * @param serialized_payload Pointer to the output serialized buffer.
+ * @return Size of the serialized buffer.
+ */
+size_t mv_function_serialize(void* payload, void** serialized_payload);
+
+/**
+ * @brief Writes a multi-valued function in the format of mv_function_serialize directly into a buffer.
+ * @param payload Pointer to the function.
+ * @param buffer Output buffer, or NULL to only compute the size.
+ * @return Size of the serialized function.
+ */
+size_t mv_function_write(void* payload, char* buffer);
+
+/**
+ * @brief Deserializes a multi-valued function from a buffer.
+ * @param serialized_payload Pointer to the serialized buffer.
+ * @param size Size of the serialized buffer.
+ * @return Pointer to the deserialized function, or NULL if the counts, domains or values do not fit the buffer.
+ */
+void* mv_function_deserialize(const void* serialized_payload, size_t size);
+
+#endif //MV_FUNCTION_H
@@ -1,59 +1,163 @@
 #include "pla_function.h"
+#include <limits.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
+static uint64_t pla_cube_read_bits(const uint64_t* src, size_t bit_offset, int bit_count) {
+    size_t word = bit_offset / 64;
+    int shift = (int)(bit_offset % 64);
+    uint64_t value = src[word] >> shift;
+    if (shift != 0 && shift + bit_count > 64) {
+        value |= src[word + 1] << (64 - shift);
+    }
+    return bit_count == 64 ? value : value & ((UINT64_C(1) << bit_count) - 1);
+}
 
-void pla_function_alloc_values(pla_function* this) {
-    this->variables_ = malloc(this->num_lines_ * sizeof(char*));
-    for (int i = 0; i < this->num_lines_; i++) {
-        this->variables_[i] = malloc(this->var_count_ * sizeof(char));
+static void pla_cube_write_bits(uint64_t* dest, size_t bit_offset, int bit_count, uint64_t value) {
+    size_t word = bit_offset / 64;
+    int shift = (int)(bit_offset % 64);
+    dest[word] |= value << shift;
+    if (shift != 0 && shift + bit_count > 64) {
+        dest[word + 1] |= value >> (64 - shift);
     }
-    this->fun_values_ = malloc(this->num_lines_ * sizeof(char));
+}
+
+int pla_function_words_per_cube(int var_count) {
+    return (var_count + PLA_LITERALS_PER_WORD - 1) / PLA_LITERALS_PER_WORD;
+}
+
+void pla_function_alloc_values(pla_function* this) {
+    this->words_per_cube_ = pla_function_words_per_cube(this->var_count_);
+    size_t cubes_size = (size_t)this->num_lines_ * this->words_per_cube_ * sizeof(uint64_t);
+    this->cubes_ = calloc(1, cubes_size + (size_t)this->num_lines_ * this->num_outputs_ * sizeof(char));
+    this->fun_values_ = (char*)this->cubes_ + cubes_size;
+    this->ref_count_ = NULL;
+    this->storage_ = NULL;
 }
 
 void pla_function_init(pla_function* this, int var_count, int line_count) {
+    pla_function_init_outputs(this, var_count, 1, line_count);
+}
+
+void pla_function_init_outputs(pla_function* this, int var_count, int num_outputs, int line_count) {
     this->num_lines_ = line_count;
     this->var_count_ = var_count;
+    this->num_outputs_ = num_outputs;
+    this->output_column_ = 0;
     this->fun_val_count_[0] = 0;
     this->fun_val_count_[1] = 0;
     pla_function_alloc_values(this);
 }
 
 void pla_function_free_values(pla_function* this) {
-    for (int i = 0; i < this->num_lines_; i++) {
-        free(this->variables_[i]);
+    if (this->ref_count_) {
+        if (__atomic_sub_fetch(this->ref_count_, 1, __ATOMIC_ACQ_REL) > 0) {
+            this->ref_count_ = NULL;
+            this->storage_ = NULL;
+            return;
+        }
+        free(this->ref_count_);
+        this->ref_count_ = NULL;
     }
-    free(this->variables_);
-    free(this->fun_values_);
+    free(this->storage_ ? this->storage_ : this->cubes_);
+    this->storage_ = NULL;
 }
 
 void pla_function_destroy(pla_function* this) {
     pla_function_free_values(this);
-    this->variables_ = NULL;
+    this->cubes_ = NULL;
     this->fun_values_ = NULL;
     this->num_lines_ = 0;
     this->var_count_ = 0;
+    this->words_per_cube_ = 0;
+    this->num_outputs_ = 0;
+    this->output_column_ = 0;
 }
 
 void pla_function_assign(pla_function *this, pla_function *other) {
     pla_function_free_values(this);
     this->num_lines_ = pla_function_get_num_lines(other);
     this->var_count_ = pla_function_get_var_count(other);
+    this->num_outputs_ = pla_function_get_num_outputs(other);
+    this->output_column_ = pla_function_get_output_column(other);
     this->fun_val_count_[0] = pla_function_get_fun_val_count(other)[0];
     this->fun_val_count_[1] = pla_function_get_fun_val_count(other)[1];
-    this->variables_ = malloc(this->num_lines_ * sizeof(char*));
-    for (int i = 0; i < this->num_lines_; i++) {
-        this->variables_[i] = malloc(this->var_count_ * sizeof(char));
-        memcpy(this->variables_[i], pla_function_get_variables(other)[i], this->var_count_ * sizeof(char));
+    pla_function_alloc_values(this);
+    memcpy(this->cubes_, other->cubes_, (size_t)this->num_lines_ * this->words_per_cube_ * sizeof(uint64_t));
+    memcpy(this->fun_values_, pla_function_get_function_values(other), (size_t)this->num_lines_ * this->num_outputs_ * sizeof(char));
+}
+
+void pla_function_assign_output(pla_function *this, pla_function *other, int output_column) {
+    int line_count = 0;
+    for (int i = 0; i < other->num_lines_; i++) {
+        char value = other->fun_values_[(size_t)i * other->num_outputs_ + output_column];
+        if (value == '0' || value == '1') {
+            line_count++;
+        }
+    }
+    pla_function_init(this, pla_function_get_var_count(other), line_count);
+
+    int line_num = 0;
+    for (int i = 0; i < other->num_lines_; i++) {
+        char value = other->fun_values_[(size_t)i * other->num_outputs_ + output_column];
+        if (value == '0' || value == '1') {
+            pla_function_add_cube(this, pla_function_get_cube(other, i), value, line_num);
+            line_num++;
+        }
+    }
+}
+
+void pla_function_move(pla_function *this, pla_function *other) {
+    if (this == other) {
+        return;
     }
+    pla_function_free_values(this);
+    *this = *other;
+    other->cubes_ = NULL;
+    other->fun_values_ = NULL;
+    other->fun_val_count_[0] = 0;
+    other->fun_val_count_[1] = 0;
+    other->num_lines_ = 0;
+    other->var_count_ = 0;
+    other->words_per_cube_ = 0;
+    other->num_outputs_ = 0;
+    other->output_column_ = 0;
+    other->ref_count_ = NULL;
+    other->storage_ = NULL;
+}
 
-    this->fun_values_ = malloc(this->num_lines_ * sizeof(char));
-    memcpy(this->fun_values_, pla_function_get_function_values(other), this->num_lines_ * sizeof(char));
+void pla_function_share(pla_function *this, pla_function *other) {
+    if (!other->ref_count_) {
+        other->ref_count_ = malloc(sizeof(int));
+        *other->ref_count_ = 1;
+    }
+    __atomic_add_fetch(other->ref_count_, 1, __ATOMIC_RELAXED);
+    *this = *other;
 }
 
-char ** pla_function_get_variables(pla_function *this) {
-    return this->variables_;
+_Bool pla_function_is_shared(pla_function *this) {
+    return this->ref_count_ && __atomic_load_n(this->ref_count_, __ATOMIC_ACQUIRE) > 1;
+}
+
+_Bool pla_function_equals(const pla_function *this, const pla_function *other) {
+    if (this->var_count_ != other->var_count_ || this->num_lines_ != other->num_lines_ ||
+        this->num_outputs_ != other->num_outputs_ || this->output_column_ != other->output_column_) {
+        return false;
+    }
+    size_t cubes_size = (size_t)this->num_lines_ * this->words_per_cube_ * sizeof(uint64_t);
+    size_t values_size = (size_t)this->num_lines_ * this->num_outputs_ * sizeof(char);
+    return memcmp(this->cubes_, other->cubes_, cubes_size) == 0 &&
+           memcmp(this->fun_values_, other->fun_values_, values_size) == 0;
+}
+
+uint64_t * pla_function_get_cube(pla_function *this, int line_num) {
+    return this->cubes_ + (size_t)line_num * this->words_per_cube_;
 }
 
 char * pla_function_get_function_values(pla_function *this) {
@@ -72,32 +176,117 @@ int * pla_function_get_fun_val_count(pla_function *this) {
     return this->fun_val_count_;
 }
 
+int pla_function_get_num_outputs(pla_function *this) {
+    return this->num_outputs_;
+}
+
+int pla_function_get_output_column(pla_function *this) {
+    return this->output_column_;
+}
+
+char pla_function_get_value(pla_function *this, int line_num) {
+    return this->fun_values_[(size_t)line_num * this->num_outputs_ + this->output_column_];
+}
+
+_Bool pla_function_select_output(pla_function *this, int output_column) {
+    if (output_column < 0 || output_column >= this->num_outputs_) {
+        fprintf(stderr, "Output column %d is out of range, function has %d outputs.\n", output_column, this->num_outputs_);
+        return false;
+    }
+    this->output_column_ = output_column;
+    this->fun_val_count_[0] = 0;
+    this->fun_val_count_[1] = 0;
+    for (int i = 0; i < this->num_lines_; i++) {
+        char value = pla_function_get_value(this, i);
+        if (value == '0' || value == '1') {
+            this->fun_val_count_[value - '0']++;
+        }
+    }
+    return true;
+}
+
+int pla_cube_get_literal(const uint64_t* cube, int position) {
+    return (int)(cube[position / PLA_LITERALS_PER_WORD] >> (PLA_LITERAL_BITS * (position % PLA_LITERALS_PER_WORD))) & PLA_LITERAL_MASK;
+}
+
+void pla_cube_set_literal(uint64_t* cube, int position, int literal) {
+    int shift = PLA_LITERAL_BITS * (position % PLA_LITERALS_PER_WORD);
+    uint64_t* word = cube + position / PLA_LITERALS_PER_WORD;
+    *word = (*word & ~((uint64_t)PLA_LITERAL_MASK << shift)) | ((uint64_t)literal << shift);
+}
+
+void pla_cube_copy_literals(uint64_t* dest, int dest_position, const uint64_t* src, int src_position, int count) {
+    size_t dest_bit = (size_t)dest_position * PLA_LITERAL_BITS;
+    size_t src_bit = (size_t)src_position * PLA_LITERAL_BITS;
+    size_t remaining = (size_t)count * PLA_LITERAL_BITS;
+    while (remaining > 0) {
+        int chunk = remaining > 64 ? 64 : (int)remaining;
+        pla_cube_write_bits(dest, dest_bit, chunk, pla_cube_read_bits(src, src_bit, chunk));
+        dest_bit += chunk;
+        src_bit += chunk;
+        remaining -= chunk;
+    }
+}
+
+void pla_cube_from_text(uint64_t* cube, const char* text, int var_count) {
+    for (int i = 0; i < var_count; i++) {
+        int literal = PLA_LITERAL_DONT_CARE;
+        if (text[i] == '0') {
+            literal = PLA_LITERAL_ZERO;
+        } else if (text[i] == '1') {
+            literal = PLA_LITERAL_ONE;
+        }
+        cube[i / PLA_LITERALS_PER_WORD] |= (uint64_t)literal << (PLA_LITERAL_BITS * (i % PLA_LITERALS_PER_WORD));
+    }
+}
+
+void pla_cube_to_text(const uint64_t* cube, int var_count, char* text) {
+    static const char literal_chars[4] = { '?', '0', '1', '-' };
+    for (int i = 0; i < var_count; i++) {
+        text[i] = literal_chars[pla_cube_get_literal(cube, i)];
+    }
+}
+
 void pla_function_add_line(pla_function* this, const char* new_vars, char value, int line_num) {
-    memcpy(*(this->variables_ + line_num), new_vars, this->var_count_ * sizeof(char));
-    *(this->fun_values_ + line_num) = value;
-    this->fun_val_count_[value - '0']++;
+    uint64_t* cube = pla_function_get_cube(this, line_num);
+    memset(cube, 0, this->words_per_cube_ * sizeof(uint64_t));
+    pla_cube_from_text(cube, new_vars, this->var_count_);
+    pla_function_set_value(this, line_num, value);
 }
 
-void pla_function_print_function(pla_function* this) {
-    char** var_ptr = this->variables_;
-    char* fun_ptr = this->fun_values_;
-    for (int i = 0; i < this->num_lines_; i++, var_ptr++, fun_ptr++) {
-        printf("%.*s\t%c\n", this->var_count_, *var_ptr, *fun_ptr);
+void pla_function_add_cube(pla_function* this, const uint64_t* cube, char value, int line_num) {
+    memcpy(pla_function_get_cube(this, line_num), cube, this->words_per_cube_ * sizeof(uint64_t));
+    pla_function_set_value(this, line_num, value);
+}
+
+void pla_function_set_value(pla_function* this, int line_num, char value) {
+    this->fun_values_[(size_t)line_num * this->num_outputs_ + this->output_column_] = value;
+    if (value == '0' || value == '1') {
+        this->fun_val_count_[value - '0']++;
     }
 }
 
-void pla_function_replace_char(const char* before, int before_length, int position, const char* input, int input_length, char* result) {
-    if (position == 0) {
-        memcpy(result, input, input_length);
-        memcpy(result + input_length, before + 1, before_length - 1);
-    } else {
-        memcpy(result, before, position);
-        memcpy(result + position, input, input_length);
-        memcpy(result + position + input_length, before + position + 1, before_length - position - 1);
+void pla_function_get_line(pla_function* this, int line_num, char* vars, char* value) {
+    pla_cube_to_text(pla_function_get_cube(this, line_num), this->var_count_, vars);
+    *value = pla_function_get_value(this, line_num);
+}
+
+void pla_function_print_function(pla_function* this) {
+    char vars[this->var_count_ + 1];
+    char value;
+    for (int i = 0; i < this->num_lines_; i++) {
+        pla_function_get_line(this, i, vars, &value);
+        printf("%.*s\t%c\n", this->var_count_, vars, value);
     }
 }
 
-void pla_function_free_sort(char*** sorted, int group_count) {
+void pla_function_replace_literal(const uint64_t* before, int before_length, int position, const uint64_t* input, int input_length, uint64_t* result) {
+    pla_cube_copy_literals(result, 0, before, 0, position);
+    pla_cube_copy_literals(result, position, input, 0, input_length);
+    pla_cube_copy_literals(result, position + input_length, before, position + 1, before_length - position - 1);
+}
+
+void pla_function_free_sort(int** sorted, int group_count) {
     if (sorted) {
         for (int i = 0; i < group_count; i++) {
             free(sorted[i]);
@@ -106,160 +295,783 @@ void pla_function_free_sort(char*** sorted, int group_count) {
     free(sorted);
 }
 
-char*** pla_function_sort_by_function(pla_function* this) {
-    char*** sorted = malloc(2 * sizeof(char**));
+int** pla_function_sort_by_function(pla_function* this) {
+    int** sorted = malloc(2 * sizeof(int*));
 
     for (int i = 0; i < 2; i++) {
-        *(sorted + i) = malloc(*(this->fun_val_count_ + i) * sizeof(char*));
+        *(sorted + i) = malloc(*(this->fun_val_count_ + i) * sizeof(int));
     }
 
-    char** var_ptr_curr = this->variables_;
-    char** var_ptr_end = this->variables_ + this->num_lines_;
-    char* fun_ptr_curr = this->fun_values_;
-    char* fun_ptr_end = this->fun_values_ + this->num_lines_;
-    char** sorted_0_curr = *sorted;
-    char** sorted_1_curr = *(sorted + 1);
-    while (var_ptr_curr != var_ptr_end && fun_ptr_curr != fun_ptr_end) {
-        if (*fun_ptr_curr == '0') {
-            *sorted_0_curr++ = *var_ptr_curr;
-        } else if (*fun_ptr_curr == '1') {
-            *sorted_1_curr++ = *var_ptr_curr;
+    int* sorted_0_curr = *sorted;
+    int* sorted_1_curr = *(sorted + 1);
+    for (int i = 0; i < this->num_lines_; i++) {
+        char value = pla_function_get_value(this, i);
+        if (value == '0') {
+            *sorted_0_curr++ = i;
+        } else if (value == '1') {
+            *sorted_1_curr++ = i;
         }
-        var_ptr_curr++;
-        fun_ptr_curr++;
     }
 
     return sorted;
 }
 
-char*** pla_function_sort_by_position(pla_function* this, int position, int* match_count) {
+int** pla_function_sort_by_position(pla_function* this, int position, int* match_count) {
     if (!match_count) { return NULL; }
-    char*** sorted = malloc(3 * sizeof(char**));
+    int** sorted = malloc(3 * sizeof(int*));
 
-    char** var_ptr = this->variables_;
-    for (int i = 0; i < this->num_lines_; i++, var_ptr++) {
-        char current_char = *(*var_ptr + position);
-        if (current_char == '0') {
-            match_count[0]++;
-        } else if (current_char == '1') {
-            match_count[1]++;
-        } else if (current_char == '-') {
-            match_count[2]++;
+    for (int i = 0; i < this->num_lines_; i++) {
+        char value = pla_function_get_value(this, i);
+        if (value == '0' || value == '1') {
+            match_count[pla_cube_get_literal(pla_function_get_cube(this, i), position) - 1]++;
         }
     }
 
     for (int group = 0; group < 3; group++) {
-        sorted[group] = malloc(match_count[group] * sizeof(char*));
+        sorted[group] = malloc(match_count[group] * sizeof(int));
     }
 
-    var_ptr = this->variables_;
     int indexes[3] = {0, 0, 0};
-    for (int i = 0; i < this->num_lines_; i++, var_ptr++) {
-        char* current_string = *var_ptr;
-        char current_char = *(current_string + position);
-        if (current_char == '0') {
-            sorted[0][indexes[0]++] = current_string;
-        } else if (current_char == '1') {
-            sorted[1][indexes[1]++] = current_string;
-        } else if (current_char == '-') {
-            sorted[2][indexes[2]++] = current_string;
+    for (int i = 0; i < this->num_lines_; i++) {
+        char value = pla_function_get_value(this, i);
+        if (value == '0' || value == '1') {
+            int group = pla_cube_get_literal(pla_function_get_cube(this, i), position) - 1;
+            sorted[group][indexes[group]++] = i;
         }
     }
 
     return sorted;
 }
 
-void pla_function_input_variables(pla_function* this, pla_function* other, int position) {
+_Bool pla_function_input_variables(pla_function* this, pla_function* other, int position) {
     if (pla_function_get_var_count(other) <= 0) {
-        return;
+        return true;
     }
     int* match_count = calloc(3, sizeof(int));
-    char*** my_vars = pla_function_sort_by_position(this, position, match_count);
-    char*** additional_vars = pla_function_sort_by_function(other);
+    int** my_lines = pla_function_sort_by_position(this, position, match_count);
+    int** additional_lines = pla_function_sort_by_function(other);
 
     int other_var_count = pla_function_get_var_count(other);
     int* other_fun_val_count = pla_function_get_fun_val_count(other);
 
-    char whatever_input[other_var_count];
-    memset(whatever_input, '-', sizeof(whatever_input));
+    uint64_t whatever_input[pla_function_words_per_cube(other_var_count)];
+    memset(whatever_input, 0, sizeof(whatever_input));
+    for (int i = 0; i < other_var_count; i++) {
+        pla_cube_set_literal(whatever_input, i, PLA_LITERAL_DONT_CARE);
+    }
 
     int new_var_count = other_var_count + this->var_count_ - 1;
-    int new_line_count = match_count[0] * other_fun_val_count[0] + match_count[1] * other_fun_val_count[1] + match_count[2];
-    char new_vars[new_var_count];
+    int64_t new_line_count = (int64_t)match_count[0] * other_fun_val_count[0] + (int64_t)match_count[1] * other_fun_val_count[1] + match_count[2];
+    if (new_line_count > INT_MAX) {
+        free(match_count);
+        pla_function_free_sort(my_lines, 3);
+        pla_function_free_sort(additional_lines, 2);
+        return false;
+    }
 
     pla_function new_pla;
-    pla_function_init(&new_pla, new_var_count, new_line_count);
+    pla_function_init(&new_pla, new_var_count, (int)new_line_count);
 
     int line_num = 0;
     for (int group = 0; group < 3; group++) {
         for (int i = 0; i < match_count[group]; i++) {
-            char* temp_line = my_vars[group][i];
-            char fun_value = pla_function_get_fun_value(this, temp_line);
+            int my_line = my_lines[group][i];
+            uint64_t* temp_line = pla_function_get_cube(this, my_line);
+            char fun_value = pla_function_get_value(this, my_line);
             if (group < 2) {
                 for (int j = 0; j < other_fun_val_count[group]; j++) {
-                    char* input_line = additional_vars[group][j];
-                    pla_function_replace_char(temp_line, this->var_count_, position, input_line, other_var_count, new_vars);
-                    pla_function_add_line(&new_pla, new_vars, fun_value, line_num);
+                    uint64_t* input_line = pla_function_get_cube(other, additional_lines[group][j]);
+                    pla_function_replace_literal(temp_line, this->var_count_, position, input_line, other_var_count, pla_function_get_cube(&new_pla, line_num));
+                    pla_function_set_value(&new_pla, line_num, fun_value);
                     line_num++;
                 }
             } else {
-                pla_function_replace_char(temp_line,this->var_count_, position, whatever_input, other_var_count, new_vars);
-                pla_function_add_line(&new_pla, new_vars, fun_value, line_num);
+                pla_function_replace_literal(temp_line, this->var_count_, position, whatever_input, other_var_count, pla_function_get_cube(&new_pla, line_num));
+                pla_function_set_value(&new_pla, line_num, fun_value);
                 line_num++;
             }
         }
     }
 
-    pla_function_assign(this, &new_pla);
+    pla_function_move(this, &new_pla);
 
-    pla_function_destroy(&new_pla);
     free(match_count);
-    pla_function_free_sort(my_vars, 3);
-    pla_function_free_sort(additional_vars, 2);
+    pla_function_free_sort(my_lines, 3);
+    pla_function_free_sort(additional_lines, 2);
+    return true;
+}
+
+typedef struct pla_cover {
+    uint64_t* cubes_;
+    int count_;
+    int capacity_;
+    int words_;
+} pla_cover;
+
+static void pla_cover_init(pla_cover* this, int words) {
+    this->cubes_ = NULL;
+    this->count_ = 0;
+    this->capacity_ = 0;
+    this->words_ = words;
+}
+
+static uint64_t* pla_cover_add(pla_cover* this, const uint64_t* cube) {
+    if (this->count_ == this->capacity_) {
+        this->capacity_ = this->capacity_ ? 2 * this->capacity_ : 8;
+        this->cubes_ = realloc(this->cubes_, (size_t)this->capacity_ * this->words_ * sizeof(uint64_t));
+    }
+    uint64_t* added = this->cubes_ + (size_t)this->count_ * this->words_;
+    memcpy(added, cube, this->words_ * sizeof(uint64_t));
+    this->count_++;
+    return added;
+}
+
+static void pla_cover_complement(const pla_cover* cover, const uint64_t* universe, int var_count, pla_cover* result) {
+    int words = cover->words_;
+    if (cover->count_ == 0) {
+        pla_cover_add(result, universe);
+        return;
+    }
+
+    int* literal_counts = calloc(var_count, sizeof(int));
+    int split = -1;
+    for (int i = 0; i < cover->count_; i++) {
+        const uint64_t* cube = cover->cubes_ + (size_t)i * words;
+        if (memcmp(cube, universe, words * sizeof(uint64_t)) == 0) {
+            free(literal_counts);
+            return;
+        }
+        for (int position = 0; position < var_count; position++) {
+            if (pla_cube_get_literal(cube, position) != PLA_LITERAL_DONT_CARE) {
+                literal_counts[position]++;
+                if (split < 0 || literal_counts[position] > literal_counts[split]) {
+                    split = position;
+                }
+            }
+        }
+    }
+    free(literal_counts);
+
+    if (cover->count_ == 1) {
+        for (int position = 0; position < var_count; position++) {
+            int literal = pla_cube_get_literal(cover->cubes_, position);
+            if (literal != PLA_LITERAL_DONT_CARE) {
+                uint64_t* added = pla_cover_add(result, universe);
+                pla_cube_set_literal(added, position, literal ^ PLA_LITERAL_MASK);
+            }
+        }
+        return;
+    }
+
+    for (int literal = PLA_LITERAL_ZERO; literal <= PLA_LITERAL_ONE; literal++) {
+        pla_cover cofactor;
+        pla_cover_init(&cofactor, words);
+        for (int i = 0; i < cover->count_; i++) {
+            const uint64_t* cube = cover->cubes_ + (size_t)i * words;
+            if (pla_cube_get_literal(cube, split) & literal) {
+                pla_cube_set_literal(pla_cover_add(&cofactor, cube), split, PLA_LITERAL_DONT_CARE);
+            }
+        }
+        int first = result->count_;
+        pla_cover_complement(&cofactor, universe, var_count, result);
+        for (int i = first; i < result->count_; i++) {
+            pla_cube_set_literal(result->cubes_ + (size_t)i * words, split, literal);
+        }
+        free(cofactor.cubes_);
+    }
+}
+
+void pla_function_complement(pla_function* this, pla_function* result) {
+    int words = this->words_per_cube_;
+    uint64_t universe[words > 0 ? words : 1];
+    memset(universe, 0, sizeof(universe));
+    for (int position = 0; position < this->var_count_; position++) {
+        pla_cube_set_literal(universe, position, PLA_LITERAL_DONT_CARE);
+    }
+
+    pla_cover on_set;
+    pla_cover_init(&on_set, words);
+    for (int i = 0; i < this->num_lines_; i++) {
+        if (pla_function_get_value(this, i) == '1') {
+            pla_cover_add(&on_set, pla_function_get_cube(this, i));
+        }
+    }
+
+    pla_cover off_set;
+    pla_cover_init(&off_set, words);
+    pla_cover_complement(&on_set, universe, this->var_count_, &off_set);
+
+    pla_function_init(result, this->var_count_, off_set.count_);
+    for (int i = 0; i < off_set.count_; i++) {
+        pla_function_add_cube(result, off_set.cubes_ + (size_t)i * words, '0', i);
+    }
+
+    free(on_set.cubes_);
+    free(off_set.cubes_);
 }
 
-char pla_function_get_fun_value(pla_function* this, const char* indexed_variables) {
-    char** var_ptr = this->variables_;
-    char* fun_ptr = this->fun_values_;
+static int pla_function_position_comparator(const void* this, const void* other) {
+    return ((const int*)this)[0] - ((const int*)other)[0];
+}
+
+_Bool pla_function_input_variables_batch(pla_function* this, pla_function** others, const int* positions, int count, _Bool on_set_only) {
+    if (count == 1 && !on_set_only) {
+        return pla_function_input_variables(this, others[0], positions[0]);
+    }
+
+    int (*order)[2] = malloc(count * sizeof(*order));
+    int son_count = 0;
+    for (int k = 0; k < count; k++) {
+        if (pla_function_get_var_count(others[k]) > 0) {
+            order[son_count][0] = positions[k];
+            order[son_count][1] = k;
+            son_count++;
+        }
+    }
+    qsort(order, son_count, sizeof(*order), pla_function_position_comparator);
+
+    pla_function* complements = malloc(son_count * sizeof(pla_function));
+    pla_function** cube_sources = malloc(2 * son_count * sizeof(pla_function*));
+    int*** son_lines = malloc(2 * son_count * sizeof(int**));
+    int* son_line_counts = malloc(2 * son_count * sizeof(int));
+    uint64_t** whatever_inputs = malloc(son_count * sizeof(uint64_t*));
+    int new_var_count = this->var_count_;
+    for (int k = 0; k < son_count; k++) {
+        pla_function* son = others[order[k][1]];
+        int son_var_count = pla_function_get_var_count(son);
+        complements[k].cubes_ = NULL;
+        cube_sources[2 * k] = son;
+        cube_sources[2 * k + 1] = son;
+        if (on_set_only) {
+            pla_function_complement(son, complements + k);
+            cube_sources[2 * k] = complements + k;
+        }
+        son_lines[2 * k] = pla_function_sort_by_function(cube_sources[2 * k]);
+        son_lines[2 * k + 1] = pla_function_sort_by_function(cube_sources[2 * k + 1]);
+        son_line_counts[2 * k] = pla_function_get_fun_val_count(cube_sources[2 * k])[0];
+        son_line_counts[2 * k + 1] = pla_function_get_fun_val_count(cube_sources[2 * k + 1])[1];
+
+        whatever_inputs[k] = calloc(pla_function_words_per_cube(son_var_count), sizeof(uint64_t));
+        for (int i = 0; i < son_var_count; i++) {
+            pla_cube_set_literal(whatever_inputs[k], i, PLA_LITERAL_DONT_CARE);
+        }
+        new_var_count += son_var_count - 1;
+    }
+
+    int* choice_counts = malloc(son_count * sizeof(int));
+    int* choices = malloc(son_count * sizeof(int));
+    // Counts saturate above INT_MAX, a result that large is not built.
+    int64_t new_line_count = 0;
+    for (int i = 0; i < this->num_lines_ && new_line_count <= INT_MAX; i++) {
+        char fun_value = pla_function_get_value(this, i);
+        if (fun_value != '1' && (on_set_only || fun_value != '0')) {
+            continue;
+        }
+        int64_t line_count = 1;
+        uint64_t* cube = pla_function_get_cube(this, i);
+        for (int k = 0; k < son_count && line_count <= INT_MAX; k++) {
+            int literal = pla_cube_get_literal(cube, order[k][0]);
+            line_count *= literal == PLA_LITERAL_DONT_CARE ? 1 : son_line_counts[2 * k + literal - PLA_LITERAL_ZERO];
+        }
+        new_line_count += line_count;
+    }
+    _Bool fits = new_line_count <= INT_MAX;
+
+    pla_function new_pla;
+    if (fits) {
+        pla_function_init(&new_pla, new_var_count, (int)new_line_count);
+    }
+
+    int line_num = 0;
+    for (int i = 0; fits && i < this->num_lines_; i++) {
+        char fun_value = pla_function_get_value(this, i);
+        if (fun_value != '1' && (on_set_only || fun_value != '0')) {
+            continue;
+        }
+        uint64_t* cube = pla_function_get_cube(this, i);
+        _Bool empty = false;
+        for (int k = 0; k < son_count; k++) {
+            int literal = pla_cube_get_literal(cube, order[k][0]);
+            choice_counts[k] = literal == PLA_LITERAL_DONT_CARE ? 1 : son_line_counts[2 * k + literal - PLA_LITERAL_ZERO];
+            choices[k] = 0;
+            empty = empty || choice_counts[k] == 0;
+        }
+        if (empty) {
+            continue;
+        }
+
+        _Bool done = false;
+        while (!done) {
+            uint64_t* result = pla_function_get_cube(&new_pla, line_num);
+            int parent_position = 0;
+            int result_position = 0;
+            for (int k = 0; k < son_count; k++) {
+                int position = order[k][0];
+                int son_var_count = pla_function_get_var_count(cube_sources[2 * k + 1]);
+                int literal = pla_cube_get_literal(cube, position);
+                const uint64_t* input = whatever_inputs[k];
+                if (literal != PLA_LITERAL_DONT_CARE) {
+                    int group = literal - PLA_LITERAL_ZERO;
+                    input = pla_function_get_cube(cube_sources[2 * k + group], son_lines[2 * k + group][group][choices[k]]);
+                }
+
+                pla_cube_copy_literals(result, result_position, cube, parent_position, position - parent_position);
+                result_position += position - parent_position;
+                pla_cube_copy_literals(result, result_position, input, 0, son_var_count);
+                result_position += son_var_count;
+                parent_position = position + 1;
+            }
+            pla_cube_copy_literals(result, result_position, cube, parent_position, this->var_count_ - parent_position);
+            pla_function_set_value(&new_pla, line_num, fun_value);
+            line_num++;
 
-    for (int i = 0; i < this->num_lines_; i++, var_ptr++, fun_ptr++) {
-        if (memcmp(*var_ptr, indexed_variables, this->var_count_) == 0) {
-            return *fun_ptr;
+            int k = son_count - 1;
+            while (k >= 0 && ++choices[k] == choice_counts[k]) {
+                choices[k] = 0;
+                k--;
+            }
+            done = k < 0;
         }
     }
 
-    return '0';
+    if (fits) {
+        pla_function_move(this, &new_pla);
+    }
+
+    for (int k = 0; k < son_count; k++) {
+        pla_function_free_sort(son_lines[2 * k], 2);
+        pla_function_free_sort(son_lines[2 * k + 1], 2);
+        if (complements[k].cubes_) {
+            pla_function_destroy(complements + k);
+        }
+        free(whatever_inputs[k]);
+    }
+    free(choices);
+    free(choice_counts);
+    free(whatever_inputs);
+    free(son_line_counts);
+    free(son_lines);
+    free(cube_sources);
+    free(complements);
+    free(order);
+    return fits;
 }
 
+static void pla_function_unshare(pla_function* this) {
+    if (!pla_function_is_shared(this)) {
+        return;
+    }
+    pla_function copy;
+    pla_function_init_outputs(&copy, this->var_count_, this->num_outputs_, this->num_lines_);
+    memcpy(copy.cubes_, this->cubes_, (size_t)this->num_lines_ * this->words_per_cube_ * sizeof(uint64_t));
+    memcpy(copy.fun_values_, this->fun_values_, (size_t)this->num_lines_ * this->num_outputs_);
+    copy.output_column_ = this->output_column_;
+    copy.fun_val_count_[0] = this->fun_val_count_[0];
+    copy.fun_val_count_[1] = this->fun_val_count_[1];
+    pla_function_move(this, &copy);
+}
+
+static uint64_t pla_cube_hash(const uint64_t* cube, int words, int position, char value) {
+    uint64_t hash = UINT64_C(14695981039346656037) ^ (unsigned char)value;
+    for (int w = 0; w < words; w++) {
+        uint64_t word = cube[w];
+        if (position >= 0 && w == position / PLA_LITERALS_PER_WORD) {
+            word |= (uint64_t)PLA_LITERAL_MASK << (PLA_LITERAL_BITS * (position % PLA_LITERALS_PER_WORD));
+        }
+        hash = (hash ^ word) * UINT64_C(1099511628211);
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+static _Bool pla_cubes_adjacent(const uint64_t* cube, const uint64_t* other, int words, int position) {
+    int position_word = position / PLA_LITERALS_PER_WORD;
+    uint64_t position_mask = (uint64_t)PLA_LITERAL_MASK << (PLA_LITERAL_BITS * (position % PLA_LITERALS_PER_WORD));
+    for (int w = 0; w < words; w++) {
+        uint64_t difference = cube[w] ^ other[w];
+        if (difference != (w == position_word ? position_mask : 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static _Bool pla_cube_contains(const uint64_t* cube, const uint64_t* other, int words) {
+    for (int w = 0; w < words; w++) {
+        if ((cube[w] & other[w]) != other[w]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int pla_cube_dont_care_count(const uint64_t* cube, int words) {
+    int count = 0;
+    for (int w = 0; w < words; w++) {
+        uint64_t word = cube[w];
+        count += __builtin_popcountll(word & (word >> 1) & UINT64_C(0x5555555555555555));
+    }
+    return count;
+}
+
+static int pla_function_merge_adjacent(pla_function* this, _Bool* removed, int* table, int table_mask, int position) {
+    int words = this->words_per_cube_;
+    int merged = 0;
+    memset(table, -1, (table_mask + 1) * sizeof(int));
+    for (int i = 0; i < this->num_lines_; i++) {
+        uint64_t* cube = pla_function_get_cube(this, i);
+        if (removed[i] || pla_cube_get_literal(cube, position) == PLA_LITERAL_DONT_CARE) {
+            continue;
+        }
+        char value = this->fun_values_[i];
+        int slot = (int)(pla_cube_hash(cube, words, position, value) & table_mask);
+        for (; table[slot] >= 0; slot = (slot + 1) & table_mask) {
+            int other = table[slot];
+            uint64_t* other_cube = pla_function_get_cube(this, other);
+            if (!removed[other] && this->fun_values_[other] == value && pla_cubes_adjacent(cube, other_cube, words, position)) {
+                pla_cube_set_literal(other_cube, position, PLA_LITERAL_DONT_CARE);
+                removed[i] = true;
+                merged++;
+                break;
+            }
+        }
+        if (!removed[i]) {
+            table[slot] = i;
+        }
+    }
+    return merged;
+}
+
+static void pla_function_remove_duplicates(pla_function* this, _Bool* removed, int* table, int table_mask) {
+    int words = this->words_per_cube_;
+    memset(table, -1, (table_mask + 1) * sizeof(int));
+    for (int i = 0; i < this->num_lines_; i++) {
+        if (removed[i]) {
+            continue;
+        }
+        uint64_t* cube = pla_function_get_cube(this, i);
+        char value = this->fun_values_[i];
+        int slot = (int)(pla_cube_hash(cube, words, -1, value) & table_mask);
+        for (; table[slot] >= 0; slot = (slot + 1) & table_mask) {
+            int other = table[slot];
+            if (this->fun_values_[other] == value && memcmp(cube, pla_function_get_cube(this, other), words * sizeof(uint64_t)) == 0) {
+                removed[i] = true;
+                break;
+            }
+        }
+        if (!removed[i]) {
+            table[slot] = i;
+        }
+    }
+}
+
+static void pla_function_remove_contained(pla_function* this, _Bool* removed) {
+    int words = this->words_per_cube_;
+    int* dont_cares = malloc(this->num_lines_ * sizeof(int));
+    for (int i = 0; i < this->num_lines_; i++) {
+        dont_cares[i] = removed[i] ? -1 : pla_cube_dont_care_count(pla_function_get_cube(this, i), words);
+    }
+    for (int i = 0; i < this->num_lines_; i++) {
+        if (removed[i]) {
+            continue;
+        }
+        uint64_t* cube = pla_function_get_cube(this, i);
+        for (int j = 0; j < this->num_lines_ && !removed[i]; j++) {
+            if (dont_cares[j] > dont_cares[i] && !removed[j] && this->fun_values_[j] == this->fun_values_[i]
+                && pla_cube_contains(pla_function_get_cube(this, j), cube, words)) {
+                removed[i] = true;
+            }
+        }
+    }
+    free(dont_cares);
+}
+
+void pla_function_simplify(pla_function* this) {
+    if (this->num_outputs_ != 1 || this->num_lines_ < 2) {
+        return;
+    }
+    pla_function_unshare(this);
+
+    int table_mask = 1;
+    while (table_mask + 1 < 2 * this->num_lines_) {
+        table_mask = 2 * table_mask + 1;
+    }
+    int* table = malloc((table_mask + 1) * sizeof(int));
+    _Bool* removed = calloc(this->num_lines_, sizeof(_Bool));
+    for (int i = 0; i < this->num_lines_; i++) {
+        char value = this->fun_values_[i];
+        removed[i] = value != '0' && value != '1';
+    }
+
+    pla_function_remove_duplicates(this, removed, table, table_mask);
+    int merged;
+    do {
+        merged = 0;
+        for (int position = 0; position < this->var_count_; position++) {
+            merged += pla_function_merge_adjacent(this, removed, table, table_mask, position);
+        }
+    } while (merged > 0);
+    pla_function_remove_duplicates(this, removed, table, table_mask);
+    if (this->num_lines_ <= PLA_SIMPLIFY_CONTAINMENT_LIMIT) {
+        pla_function_remove_contained(this, removed);
+    }
+
+    int words = this->words_per_cube_;
+    int line_count = 0;
+    this->fun_val_count_[0] = 0;
+    this->fun_val_count_[1] = 0;
+    for (int i = 0; i < this->num_lines_; i++) {
+        if (removed[i]) {
+            continue;
+        }
+        if (line_count != i) {
+            memcpy(pla_function_get_cube(this, line_count), pla_function_get_cube(this, i), words * sizeof(uint64_t));
+        }
+        this->fun_values_[line_count] = this->fun_values_[i];
+        this->fun_val_count_[this->fun_values_[i] - '0']++;
+        line_count++;
+    }
+
+    if (line_count < this->num_lines_) {
+        pla_function compact;
+        pla_function_init(&compact, this->var_count_, line_count);
+        memcpy(compact.cubes_, this->cubes_, (size_t)line_count * words * sizeof(uint64_t));
+        memcpy(compact.fun_values_, this->fun_values_, line_count);
+        compact.fun_val_count_[0] = this->fun_val_count_[0];
+        compact.fun_val_count_[1] = this->fun_val_count_[1];
+        pla_function_move(this, &compact);
+    }
+
+    free(removed);
+    free(table);
+}
+
+static _Bool pla_is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '|';
+}
+
+static const char* pla_skip_blanks(const char* cursor, const char* line_end) {
+    while (cursor < line_end && pla_is_blank(*cursor)) {
+        cursor++;
+    }
+    return cursor;
+}
+
+static int pla_parse_int(const char* cursor, const char* line_end) {
+    int value = 0;
+    cursor = pla_skip_blanks(cursor, line_end);
+    while (cursor < line_end && *cursor >= '0' && *cursor <= '9') {
+        value = value * 10 + (*cursor - '0');
+        cursor++;
+    }
+    return value;
+}
+
+static _Bool pla_keyword_equals(const char* keyword, size_t keyword_length, const char* expected) {
+    return keyword_length == strlen(expected) && memcmp(keyword, expected, keyword_length) == 0;
+}
+
+static _Bool pla_function_parse_cube(pla_function* this, const char* cursor, const char* line_end, int line_num) {
+    uint64_t* cube = pla_function_get_cube(this, line_num);
+    uint64_t word = 0;
+    int position = 0;
+
+    memset(cube, 0, this->words_per_cube_ * sizeof(uint64_t));
+    while (position < this->var_count_ && cursor < line_end) {
+        char c = *cursor++;
+        if (pla_is_blank(c)) {
+            continue;
+        }
+        uint64_t literal = c == '0' ? PLA_LITERAL_ZERO : c == '1' ? PLA_LITERAL_ONE : PLA_LITERAL_DONT_CARE;
+        word |= literal << (PLA_LITERAL_BITS * (position % PLA_LITERALS_PER_WORD));
+        position++;
+        if (position % PLA_LITERALS_PER_WORD == 0) {
+            cube[position / PLA_LITERALS_PER_WORD - 1] = word;
+            word = 0;
+        }
+    }
+    if (position < this->var_count_) {
+        return false;
+    }
+    if (position % PLA_LITERALS_PER_WORD != 0) {
+        cube[position / PLA_LITERALS_PER_WORD] = word;
+    }
+
+    char* values = this->fun_values_ + (size_t)line_num * this->num_outputs_;
+    int output = 0;
+    while (output < this->num_outputs_ && cursor < line_end) {
+        char c = *cursor++;
+        if (pla_is_blank(c)) {
+            continue;
+        }
+        values[output++] = c == '0' ? '0' : (c == '1' || c == '4') ? '1' : '-';
+    }
+    return output == this->num_outputs_;
+}
+
+_Bool pla_function_parse(pla_function* this, const char* text, size_t length) {
+    const char* end = text + length;
+    const char* cursor = text;
+    const char* body = NULL;
+    const char* body_end = end;
+    int var_count = 0, num_outputs = 0, line_count = 0;
+
+    while (cursor < end) {
+        const char* line_end = memchr(cursor, '\n', end - cursor);
+        if (!line_end) {
+            line_end = end;
+        }
+        const char* start = pla_skip_blanks(cursor, line_end);
+
+        if (start < line_end && *start == '.') {
+            const char* keyword_end = start;
+            while (keyword_end < line_end && !pla_is_blank(*keyword_end)) {
+                keyword_end++;
+            }
+            size_t keyword_length = keyword_end - start;
+            if (pla_keyword_equals(start, keyword_length, ".e") || pla_keyword_equals(start, keyword_length, ".end")) {
+                body_end = cursor;
+                break;
+            }
+            if (pla_keyword_equals(start, keyword_length, ".i")) {
+                var_count = pla_parse_int(keyword_end, line_end);
+            } else if (pla_keyword_equals(start, keyword_length, ".o")) {
+                num_outputs = pla_parse_int(keyword_end, line_end);
+            }
+        } else if (start < line_end && *start != '#') {
+            if (!body) {
+                body = cursor;
+            }
+            line_count++;
+        }
+
+        cursor = line_end + 1;
+    }
+
+    if (var_count <= 0 || num_outputs <= 0) {
+        fprintf(stderr, "Not enough info (.i, .o) from PLA file.\n");
+        pla_function_init(this, 0, 0);
+        return false;
+    }
+
+    pla_function_init_outputs(this, var_count, num_outputs, line_count);
+
+    int line_index = 0;
+    cursor = body ? body : body_end;
+    while (cursor < body_end) {
+        const char* line_end = memchr(cursor, '\n', body_end - cursor);
+        if (!line_end) {
+            line_end = body_end;
+        }
+        const char* start = pla_skip_blanks(cursor, line_end);
+
+        if (start < line_end && *start != '#' && *start != '.') {
+            if (pla_function_parse_cube(this, start, line_end, line_index)) {
+                line_index++;
+            }
+        }
+
+        cursor = line_end + 1;
+    }
+
+    this->num_lines_ = line_index;
+    pla_function_select_output(this, 0);
+    return true;
+}
+
+const char* pla_function_map_file(const char* path, size_t* length) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open PLA file");
+        return NULL;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) < 0 || file_stat.st_size == 0) {
+        fprintf(stderr, "PLA file %s is empty or unreadable.\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    *length = (size_t)file_stat.st_size;
+    void* text = mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        perror("Failed to map PLA file");
+        return NULL;
+    }
+    madvise(text, *length, MADV_SEQUENTIAL);
+    return text;
+}
+
+void pla_function_unmap_file(const char* text, size_t length) {
+    munmap((void*)text, length);
+}
+
+_Bool pla_function_load_file(pla_function* this, const char* path) {
+    size_t length = 0;
+    const char* text = pla_function_map_file(path, &length);
+    if (!text) {
+        pla_function_init(this, 0, 0);
+        return false;
+    }
+
+    _Bool result = pla_function_parse(this, text, length);
+
+    pla_function_unmap_file(text, length);
+    return result;
+}
 
 size_t pla_function_serialize(void *payload, void **serialized_payload) {
+    size_t total_size = pla_function_write(payload, NULL);
+
+    *serialized_payload = malloc(total_size);
+
+    return pla_function_write(payload, *serialized_payload);
+}
+
+size_t pla_function_write(void *payload, char *buffer) {
     pla_function *this = (pla_function *)payload;
 
+    int num_lines = this->fun_val_count_[0] + this->fun_val_count_[1];
+    size_t cube_size = this->words_per_cube_ * sizeof(uint64_t);
     size_t total_size = 0;
 
     total_size += sizeof(int) * 2;
     total_size += sizeof(int) * 2;
-    total_size += this->num_lines_ * this->var_count_;
-    total_size += this->num_lines_;
+    total_size += num_lines * cube_size;
+    total_size += num_lines;
 
-    *serialized_payload = malloc(total_size);
+    if (!buffer) {
+        return total_size;
+    }
 
-    char *current_ptr = *serialized_payload;
+    char *current_ptr = buffer;
 
     memcpy(current_ptr, this->fun_val_count_, sizeof(int) * 2);
     current_ptr += sizeof(int) * 2;
 
-    memcpy(current_ptr, &this->num_lines_, sizeof(int));
+    memcpy(current_ptr, &num_lines, sizeof(int));
     current_ptr += sizeof(int);
     memcpy(current_ptr, &this->var_count_, sizeof(int));
     current_ptr += sizeof(int);
 
-    for (int i = 0; i < this->num_lines_; i++) {
-        memcpy(current_ptr, this->variables_[i], this->var_count_);
-        current_ptr += this->var_count_;
+    if (this->num_outputs_ == 1 && num_lines == this->num_lines_) {
+        memcpy(current_ptr, this->cubes_, num_lines * cube_size);
+        current_ptr += num_lines * cube_size;
+        memcpy(current_ptr, this->fun_values_, num_lines);
+        return total_size;
     }
 
-    memcpy(current_ptr, this->fun_values_, this->num_lines_);
+    char *values_ptr = current_ptr + num_lines * cube_size;
+    for (int i = 0; i < this->num_lines_; i++) {
+        char value = pla_function_get_value(this, i);
+        if (value == '0' || value == '1') {
+            memcpy(current_ptr, pla_function_get_cube(this, i), cube_size);
+            current_ptr += cube_size;
+            *values_ptr++ = value;
+        }
+    }
 
     return total_size;
 }
@@ -281,18 +1093,61 @@ void * pla_function_deserialize(const void *serialized_payload, size_t size) {
     memcpy(&deserialized->var_count_, buffer, sizeof(int));
     buffer += sizeof(int);
 
-    deserialized->variables_ = malloc(deserialized->num_lines_ * sizeof(char*));
-
-    deserialized->fun_values_ = malloc(deserialized->num_lines_ * sizeof(char));
+    deserialized->num_outputs_ = 1;
+    deserialized->output_column_ = 0;
+    pla_function_alloc_values(deserialized);
 
-    for (int i = 0; i < deserialized->num_lines_; i++) {
-        deserialized->variables_[i] = malloc(deserialized->var_count_ * sizeof(char));
-        memcpy(deserialized->variables_[i], buffer, deserialized->var_count_ * sizeof(char));
-        buffer += deserialized->var_count_ * sizeof(char);
-    }
+    size_t cubes_size = (size_t)deserialized->num_lines_ * deserialized->words_per_cube_ * sizeof(uint64_t);
+    memcpy(deserialized->cubes_, buffer, cubes_size);
+    buffer += cubes_size;
 
     memcpy(deserialized->fun_values_, buffer, deserialized->num_lines_ * sizeof(char));
 
     return deserialized;
 }
 
+void * pla_function_deserialize_in_place(void *buffer, void *serialized_payload, size_t size) {
+    if (!buffer || !serialized_payload || size < sizeof(int) * 4) {
+        return NULL;
+    }
+
+    char* cursor = serialized_payload;
+
+    pla_function* deserialized = malloc(sizeof(pla_function));
+    if (!deserialized) {
+        return NULL;
+    }
+
+    memcpy(deserialized->fun_val_count_, cursor, sizeof(int) * 2);
+    cursor += sizeof(int) * 2;
+
+    memcpy(&deserialized->num_lines_, cursor, sizeof(int));
+    cursor += sizeof(int);
+    memcpy(&deserialized->var_count_, cursor, sizeof(int));
+    cursor += sizeof(int);
+
+    deserialized->num_outputs_ = 1;
+    deserialized->output_column_ = 0;
+    deserialized->words_per_cube_ = pla_function_words_per_cube(deserialized->var_count_);
+    deserialized->ref_count_ = NULL;
+
+    size_t cubes_size = (size_t)deserialized->num_lines_ * deserialized->words_per_cube_ * sizeof(uint64_t);
+    size_t values_size = (size_t)deserialized->num_lines_ * sizeof(char);
+    if (size - sizeof(int) * 4 < cubes_size + values_size) {
+        free(deserialized);
+        return NULL;
+    }
+
+    // Senders align the cubes, an unaligned block is moved back over the already read header.
+    size_t misalignment = (uintptr_t)cursor % _Alignof(uint64_t);
+    if (misalignment != 0) {
+        memmove(cursor - misalignment, cursor, cubes_size + values_size);
+        cursor -= misalignment;
+    }
+
+    deserialized->cubes_ = (uint64_t*)cursor;
+    deserialized->fun_values_ = cursor + cubes_size;
+    deserialized->storage_ = buffer;
+
+    return deserialized;
+}
@@ -1,25 +1,66 @@
 #ifndef PLA_FUNCTION_H
 #define PLA_FUNCTION_H
 #include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Literal encoding used by packed cubes.
+ *
+ * Every input literal takes two bits (positional cube notation), 32 literals
+ * are stored in one 64-bit word. Unused bits at the end of a cube are zero.
+ * - PLA_LITERAL_ZERO: variable must be '0'.
+ * - PLA_LITERAL_ONE: variable must be '1'.
+ * - PLA_LITERAL_DONT_CARE: variable can be anything ('-').
+ */
+#define PLA_LITERAL_BITS 2
+#define PLA_LITERALS_PER_WORD 32
+#define PLA_LITERAL_MASK 0x3
+#define PLA_LITERAL_ZERO 0x1
+#define PLA_LITERAL_ONE 0x2
+#define PLA_LITERAL_DONT_CARE 0x3
+
+/**
+ * @brief Largest number of lines on which pla_function_simplify runs the
+ * quadratic single-cube containment check.
+ */
+#define PLA_SIMPLIFY_CONTAINMENT_LIMIT 8192
 
 /**
  * @brief Represents a PLA (Programmable Logic Array) function.
  *
  * Fields:
- * - variables_: 2D array of input variable combinations.
- * - fun_values_: Array of function output values ('0' or '1').
- * - fun_val_count_: Count of function values ('0' and '1').
+ * - cubes_: Contiguous block of packed input cubes, words_per_cube_ words per line.
+ * - fun_values_: Matrix of function output values ('0', '1' or '-'), num_outputs_
+ *   values per line, stored in the same allocation right after the cubes.
+ * - fun_val_count_: Count of function values ('0' and '1') in the selected output.
  * - num_lines_: Number of lines (rows) in the PLA.
  * - var_count_: Number of input variables.
+ * - words_per_cube_: Number of 64-bit words used by one packed cube.
+ * - num_outputs_: Number of output columns stored per line.
+ * - output_column_: Output column the function currently represents.
+ * - ref_count_: Number of functions sharing cubes_, updated atomically, NULL if the storage is not shared.
+ * - storage_: Allocation containing cubes_ when cubes_ does not start it (a received message buffer), otherwise NULL.
  */
 typedef struct pla_function {
-    char** variables_;
+    uint64_t* cubes_;
     char* fun_values_;
     int fun_val_count_[2];
     int num_lines_;
     int var_count_;
+    int words_per_cube_;
+    int num_outputs_;
+    int output_column_;
+    int* ref_count_;
+    void* storage_;
 } pla_function;
 
+/**
+ * @brief Computes how many 64-bit words are needed to store a cube.
+ * @param var_count Number of input variables.
+ * @return Number of words per packed cube.
+ */
+int pla_function_words_per_cube(int var_count);
+
 /**
  * @brief Allocates memory for the PLA function values.
  * @param this Pointer to the PLA function.
@@ -34,8 +75,19 @@ void pla_function_alloc_values(pla_function* this);
  */
 void pla_function_init(pla_function* this, int var_count, int line_count);
 
+/**
+ * @brief Initializes a PLA function structure with several output columns.
+ * @param this Pointer to the PLA function.
+ * @param var_count Number of input variables.
+ * @param num_outputs Number of output columns.
+ * @param line_count Number of lines in the PLA.
+ */
+void pla_function_init_outputs(pla_function* this, int var_count, int num_outputs, int line_count);
+
 /**
  * @brief Frees memory allocated for the PLA function values.
+ *
+ * Shared storage is only released by the last function referencing it.
  * @param this Pointer to the PLA function.
  */
 void pla_function_free_values(pla_function* this);
@@ -53,13 +105,58 @@ void pla_function_destroy(pla_function* this);
  */
 void pla_function_assign(pla_function* this, pla_function* other);
 
+/**
+ * @brief Copies a single output column of a PLA function into another one.
+ *
+ * Only lines whose value in the column is '0' or '1' are copied, the result
+ * has one output.
+ * @param this Pointer to the uninitialized destination PLA function.
+ * @param other Pointer to the source PLA function.
+ * @param output_column Output column of the source to copy.
+ */
+void pla_function_assign_output(pla_function* this, pla_function* other, int output_column);
+
+/**
+ * @brief Moves the contents of one PLA function to another without copying.
+ * @param this Pointer to the destination PLA function.
+ * @param other Pointer to the source PLA function, left empty.
+ */
+void pla_function_move(pla_function* this, pla_function* other);
+
+/**
+ * @brief Makes a PLA function share the storage of another one.
+ *
+ * The storage is copy-on-write: it must not be modified in place while
+ * shared, operations that rebuild the function (merging, assigning) drop
+ * the share and leave the other functions untouched.
+ * @param this Pointer to the uninitialized destination PLA function.
+ * @param other Pointer to the source PLA function.
+ */
+void pla_function_share(pla_function* this, pla_function* other);
+
+/**
+ * @brief Checks whether the storage of a PLA function is shared with another one.
+ * @param this Pointer to the PLA function.
+ * @return true if the storage is shared, false otherwise.
+ */
+_Bool pla_function_is_shared(pla_function* this);
+
+/**
+ * @brief Checks whether two PLA functions hold the same cubes and output values.
+ * @param this Pointer to the first PLA function.
+ * @param other Pointer to the second PLA function.
+ * @return true if the functions are equal, false otherwise.
+ */
+_Bool pla_function_equals(const pla_function* this, const pla_function* other);
+
 
 /**
- * @brief Gets the variables array of the PLA function.
+ * @brief Gets the packed cube stored on a line of the PLA function.
  * @param this Pointer to the PLA function.
- * @return Pointer to the variables array.
+ * @param line_num Line number of the cube.
+ * @return Pointer to the first word of the packed cube.
  */
-char** pla_function_get_variables(pla_function* this);
+uint64_t* pla_function_get_cube(pla_function* this, int line_num);
 
 /**
  * @brief Gets the function values array of the PLA function.
@@ -89,15 +186,119 @@ int pla_function_get_var_count(pla_function* this);
  */
 int* pla_function_get_fun_val_count(pla_function* this);
 
+/**
+ * @brief Gets the number of output columns of the PLA function.
+ * @param this Pointer to the PLA function.
+ * @return Number of output columns.
+ */
+int pla_function_get_num_outputs(pla_function* this);
+
+/**
+ * @brief Gets the selected output column of the PLA function.
+ * @param this Pointer to the PLA function.
+ * @return Selected output column.
+ */
+int pla_function_get_output_column(pla_function* this);
+
+/**
+ * @brief Gets the value of a line in the selected output column.
+ * @param this Pointer to the PLA function.
+ * @param line_num Line number to read.
+ * @return Function value ('0', '1' or '-').
+ */
+char pla_function_get_value(pla_function* this, int line_num);
+
+/**
+ * @brief Selects the output column the PLA function represents.
+ *
+ * Lines whose value in the column is not '0' or '1' are ignored by sorting,
+ * merging and serialization.
+ * @param this Pointer to the PLA function.
+ * @param output_column Output column to select.
+ * @return true if the column exists, false otherwise.
+ */
+_Bool pla_function_select_output(pla_function* this, int output_column);
+
+/**
+ * @brief Gets a single literal of a packed cube.
+ * @param cube Pointer to the packed cube.
+ * @param position Position of the literal.
+ * @return Literal code (PLA_LITERAL_ZERO, PLA_LITERAL_ONE or PLA_LITERAL_DONT_CARE).
+ */
+int pla_cube_get_literal(const uint64_t* cube, int position);
+
+/**
+ * @brief Sets a single literal of a packed cube.
+ * @param cube Pointer to the packed cube.
+ * @param position Position of the literal.
+ * @param literal Literal code to store.
+ */
+void pla_cube_set_literal(uint64_t* cube, int position, int literal);
+
+/**
+ * @brief Copies a range of literals between packed cubes.
+ *
+ * The destination range has to be zeroed, literals are OR-ed into it
+ * a machine word at a time.
+ * @param dest Pointer to the destination cube.
+ * @param dest_position Position of the first destination literal.
+ * @param src Pointer to the source cube.
+ * @param src_position Position of the first source literal.
+ * @param count Number of literals to copy.
+ */
+void pla_cube_copy_literals(uint64_t* dest, int dest_position, const uint64_t* src, int src_position, int count);
+
+/**
+ * @brief Packs a text cube ('0', '1', '-') into the packed form.
+ * @param cube Pointer to the zeroed packed cube.
+ * @param text Text form of the cube.
+ * @param var_count Number of input variables.
+ */
+void pla_cube_from_text(uint64_t* cube, const char* text, int var_count);
+
+/**
+ * @brief Unpacks a packed cube into its text form ('0', '1', '-').
+ * @param cube Pointer to the packed cube.
+ * @param var_count Number of input variables.
+ * @param text Output buffer with at least var_count characters.
+ */
+void pla_cube_to_text(const uint64_t* cube, int var_count, char* text);
+
 /**
  * @brief Adds a new line to the PLA function.
  * @param this Pointer to the PLA function.
- * @param new_vars Pointer to the new input variable combination.
+ * @param new_vars Pointer to the new input variable combination in text form.
  * @param value Function output value ('0' or '1').
  * @param line_num Line number to add the data to.
  */
 void pla_function_add_line(pla_function* this, const char* new_vars, char value, int line_num);
 
+/**
+ * @brief Adds a new line holding an already packed cube to the PLA function.
+ * @param this Pointer to the PLA function.
+ * @param cube Pointer to the packed cube.
+ * @param value Function output value ('0' or '1').
+ * @param line_num Line number to add the data to.
+ */
+void pla_function_add_cube(pla_function* this, const uint64_t* cube, char value, int line_num);
+
+/**
+ * @brief Sets the function value of a line whose cube was written in place.
+ * @param this Pointer to the PLA function.
+ * @param line_num Line number to set.
+ * @param value Function output value ('0' or '1').
+ */
+void pla_function_set_value(pla_function* this, int line_num, char value);
+
+/**
+ * @brief Gets a line of the PLA function in text form.
+ * @param this Pointer to the PLA function.
+ * @param line_num Line number to read.
+ * @param vars Output buffer with at least var_count_ characters.
+ * @param value Output function value.
+ */
+void pla_function_get_line(pla_function* this, int line_num, char* vars, char* value);
+
 /**
  * @brief Prints the PLA function (variables and their corresponding values).
  * @param this Pointer to the PLA function.
@@ -105,63 +306,148 @@ void pla_function_add_line(pla_function* this, const char* new_vars, char value,
 void pla_function_print_function(pla_function* this);
 
 /**
- * @brief Replaces a character in a string at a specified position.
- * @param before Original string.
- * @param before_length Length of the original string.
- * @param position Position of the character to replace.
- * @param input Replacement string.
- * @param input_length Length of the replacement string.
- * @param result Output buffer to store the result.
+ * @brief Replaces a literal in a packed cube by another packed cube.
+ * @param before Original cube.
+ * @param before_length Number of literals in the original cube.
+ * @param position Position of the literal to replace.
+ * @param input Replacement cube.
+ * @param input_length Number of literals in the replacement cube.
+ * @param result Zeroed output cube to store the result.
  */
-void pla_function_replace_char(const char* before, int before_length, int position, const char* input, int input_length, char* result);
+void pla_function_replace_literal(const uint64_t* before, int before_length, int position, const uint64_t* input, int input_length, uint64_t* result);
 
 /**
  * @brief Frees memory allocated for sorted arrays.
  * @param sorted Pointer to the sorted arrays.
  * @param group_count Number of groups in the sorted arrays.
  */
-void pla_function_free_sort(char*** sorted, int group_count);
+void pla_function_free_sort(int** sorted, int group_count);
 
 /**
- * @brief Sorts the PLA function variables by their function values.
+ * @brief Sorts the PLA function lines by their function values.
  * @param this Pointer to the PLA function.
- * @return Pointer to an array containing sorted variables by '0' and '1'.
+ * @return Pointer to an array containing line indices sorted by '0' and '1'.
  */
-char*** pla_function_sort_by_function(pla_function* this);
+int** pla_function_sort_by_function(pla_function* this);
 
 /**
- * @brief Sorts the PLA function variables by a specific position.
+ * @brief Sorts the PLA function lines by a specific position.
+ *
+ * Lines are referenced by their index, so every sorted cube keeps
+ * access to its own function value.
  * @param this Pointer to the PLA function.
  * @param position Position to sort by.
  * @param match_count Array to store the count of matches for '0', '1', and '-'.
- * @return Pointer to an array containing sorted variables by position.
+ * @return Pointer to an array containing line indices sorted by position.
  */
-char*** pla_function_sort_by_position(pla_function* this, int position, int* match_count);
+int** pla_function_sort_by_position(pla_function* this, int position, int* match_count);
 
 /**
  * @brief Inputs additional variables from another PLA function.
  * @param this Pointer to the target PLA function.
  * @param other Pointer to the source PLA function.
  * @param position Position to insert the variables.
+ * @return true if the variables were input, false if the result would have more than INT_MAX cubes and the function is unchanged.
+ */
+_Bool pla_function_input_variables(pla_function* this, pla_function* other, int position);
+
+/**
+ * @brief Computes the off-set of a PLA function as the complement of its on-set.
+ *
+ * The on-set cover is split recursively on its most used variable until
+ * the cofactors are empty, universal or a single cube.
+ * @param this Pointer to the PLA function.
+ * @param result Pointer to the uninitialized PLA function receiving '0' cubes.
+ */
+void pla_function_complement(pla_function* this, pla_function* result);
+
+/**
+ * @brief Inputs additional variables from several PLA functions in one pass.
+ *
+ * Gives the same function as calling pla_function_input_variables for every
+ * source, without building the intermediate PLAs. Positions refer to the
+ * variables of the target before any source is inserted and must differ.
+ *
+ * With on_set_only, '0' cubes of the target and the sources are ignored, so
+ * the result holds the on-set only. The off-set of every source is then the
+ * complement of its on-set, computed by pla_function_complement.
+ * @param this Pointer to the target PLA function.
+ * @param others Array of pointers to the source PLA functions.
+ * @param positions Array of positions to insert the variables of each source.
+ * @param count Number of sources.
+ * @param on_set_only Whether only the on-set of the result is built.
+ * @return true if the variables were input, false if the result would have more than INT_MAX cubes and the function is unchanged.
  */
-void pla_function_input_variables(pla_function* this, pla_function* other, int position);
+_Bool pla_function_input_variables_batch(pla_function* this, pla_function** others, const int* positions, int count, _Bool on_set_only);
 
 /**
- * @brief Gets the function value for a specific variable combination.
+ * @brief Reduces the number of cubes without changing the function.
+ *
+ * Works separately on the '0' and '1' cubes: removes duplicates, merges
+ * cubes that differ in a single literal ('0' and '1' into '-') until no more
+ * merges are possible and, for functions up to PLA_SIMPLIFY_CONTAINMENT_LIMIT
+ * lines, removes cubes contained in another cube. Only single-output
+ * functions are simplified, shared storage is copied first.
  * @param this Pointer to the PLA function.
- * @param indexed_variables Pointer to the variable combination.
- * @return Corresponding function value ('0' or '1').
  */
-char pla_function_get_fun_value(pla_function* this, const char* indexed_variables);
+void pla_function_simplify(pla_function* this);
+
+/**
+ * @brief Parses the text of a PLA file directly into the packed storage.
+ *
+ * Lines can have any length, the number of cubes is counted from the text
+ * itself, so a missing or wrong .p header does not matter. All output
+ * columns are kept, output 0 is selected. On failure the function is left
+ * empty.
+ * @param this Pointer to the uninitialized PLA function.
+ * @param text Pointer to the PLA file contents (does not need to be null terminated).
+ * @param length Length of the contents.
+ * @return true if the function was parsed, false otherwise.
+ */
+_Bool pla_function_parse(pla_function* this, const char* text, size_t length);
+
+/**
+ * @brief Maps a PLA file into memory for reading.
+ * @param path Path to the PLA file.
+ * @param length Output length of the mapped contents.
+ * @return Pointer to the contents, or NULL on failure.
+ */
+const char* pla_function_map_file(const char* path, size_t* length);
+
+/**
+ * @brief Unmaps a PLA file mapped by pla_function_map_file.
+ * @param text Pointer to the mapped contents.
+ * @param length Length of the mapped contents.
+ */
+void pla_function_unmap_file(const char* text, size_t length);
+
+/**
+ * @brief Maps a PLA file into memory and parses it into the PLA function.
+ * @param this Pointer to the uninitialized PLA function.
+ * @param path Path to the PLA file.
+ * @return true if the file was loaded, false otherwise.
+ */
+_Bool pla_function_load_file(pla_function* this, const char* path);
 
 /**
  * @brief Serializes a PLA function into a buffer.
+ *
+ * Only the selected output column is written, so the receiver gets
+ * a single-output function.
  * @param payload Pointer to the PLA function.
  * @param serialized_payload Pointer to the output serialized buffer.
  * @return Size of the serialized buffer.
  */
 size_t pla_function_serialize(void* payload, void** serialized_payload);
 
+/**
+ * @brief Writes a PLA function in the format of pla_function_serialize directly into a buffer.
+ * @param payload Pointer to the PLA function.
+ * @param buffer Output buffer, or NULL to only compute the size.
+ * @return Size of the serialized function.
+ */
+size_t pla_function_write(void* payload, char* buffer);
+
 /**
  * @brief Deserializes a PLA function from a buffer.
  * @param serialized_payload Pointer to the serialized buffer.
@@ -170,4 +456,17 @@ size_t pla_function_serialize(void* payload, void** serialized_payload);
  */
 void* pla_function_deserialize(const void* serialized_payload, size_t size);
 
+/**
+ * @brief Deserializes a PLA function that keeps its cubes in the serialized buffer.
+ *
+ * The cubes and values are used where they are instead of being copied.
+ * On success the function takes ownership of the buffer and frees it when
+ * it is destroyed.
+ * @param buffer Allocation containing the serialized function.
+ * @param serialized_payload Pointer to the serialized function inside the buffer.
+ * @param size Size of the serialized function.
+ * @return Pointer to the deserialized PLA function, or NULL without taking the buffer.
+ */
+void* pla_function_deserialize_in_place(void* buffer, void* serialized_payload, size_t size);
+
 #endif //PLA_FUNCTION_H